@@ -0,0 +1,106 @@
+/*
+ * 列扫描 微基准：行/秒 + 实际读到的字节/秒
+ * - rows：旧路径 遍历 vector<Transaction> 按 dateKey 过滤 累加 pay/amount/points
+ * - sum/<level>：同样的区间合计 在 TransactionColumns 上用 column_scan.h 的内核 分别强制 scalar / sse2 / avx2
+ * - select/<level>：只过滤出行号（商品汇总 / 区间排行用）
+ * 区间取全年的一半（命中约 50% 分支预测最差的情况）
+ *
+ * 编译：g++ -std=c++17 -O2 -pthread -I../src bench_columns.cpp -o bench_columns
+ * 运行：./bench_columns [百万行 默认 20] [轮数 默认 5]
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "transaction_columns.h"
+#include "column_scan.h"
+
+using namespace std;
+
+template <typename Fn>
+static double secondsOf(Fn fn) {
+    auto t0 = chrono::steady_clock::now();
+    fn();
+    auto t1 = chrono::steady_clock::now();
+    return chrono::duration<double>(t1 - t0).count();
+}
+
+static void report(const char* name, size_t rows, size_t bytes, size_t hits, double sec) {
+    printf("%-14s %8.1f Mrows/s %8.1f MB/s  hits=%zu  time=%.3fs\n", name, rows / sec / 1e6, bytes / sec / 1e6, hits, sec);
+}
+
+int main(int argc, char** argv) {
+    const size_t n = static_cast<size_t>((argc > 1) ? atoi(argv[1]) : 20) * 1000000;
+    const int rounds = (argc > 2) ? atoi(argv[2]) : 5;
+
+    vector<Transaction> rows(n);
+    vector<uint8_t> flags(n, 0);
+    srand(12345);
+    for (size_t i = 0; i < n; ++i) {
+        Transaction& t = rows[i];
+        t.transactionId = static_cast<long>(i + 1);
+        t.memberHandle = static_cast<uint32_t>(rand() % 100000);
+        t.dateKey = 20260000 + (1 + rand() % 12) * 100 + 1 + rand() % 28;
+        char date[10];
+        TransactionColumns::formatDate(t.dateKey, date);
+        t.date.assign(date, 10);
+        t.itemCode = static_cast<uint32_t>(rand() % 50);
+        t.amount = Money::fromCents(rand() % 500000);
+        t.pay = Money::fromCents(rand() % 500000);
+        t.pointsEarned = rand() % 500;
+        if (rand() % 100 == 0) flags[i] = 1;
+    }
+    TransactionColumns cols;
+    cols.reserve(n);
+    for (size_t i = 0; i < n; ++i) cols.push(rows[i]);
+    const int lo = 20260301, hi = 20260831;
+
+    // 旧路径：结构体数组
+    {
+        size_t hits = 0;
+        long long pay = 0, amount = 0, points = 0;
+        double sec = secondsOf([&]() {
+            for (int r = 0; r < rounds; ++r) {
+                for (size_t i = 0; i < n; ++i) {
+                    const Transaction& t = rows[i];
+                    if ((flags[i] & 1) || t.dateKey < lo || t.dateKey > hi) continue;
+                    ++hits;
+                    pay += t.pay.cents();
+                    amount += t.amount.cents();
+                    points += t.pointsEarned;
+                }
+            }
+        });
+        report("rows", n * rounds, n * rounds * sizeof(Transaction), hits / rounds, sec);
+        if (pay == 42) printf("%lld %lld\n", amount, points);   // 防止被整个优化掉
+    }
+
+    const size_t sumBytes = sizeof(int32_t) + sizeof(uint8_t) + 2 * sizeof(int64_t) + sizeof(int32_t);
+    const simd::Level best = simd::activeLevel();
+    for (int lv = simd::kScalar; lv <= best; ++lv) {
+        simd::forceLevel(static_cast<simd::Level>(lv));
+        simd::RangeTotals t;
+        double sec = secondsOf([&]() {
+            for (int r = 0; r < rounds; ++r) {
+                t = simd::sumBetween(cols.dateKey.data(), flags.data(), 1, cols.amountCents.data(),
+                                     cols.payCents.data(), cols.points.data(), n, lo, hi);
+            }
+        });
+        string name = string("sum/") + simd::levelName(simd::activeLevel());
+        report(name.c_str(), n * rounds, n * rounds * sumBytes, t.count, sec);
+    }
+
+    vector<uint32_t> out(n);
+    for (int lv = simd::kScalar; lv <= best; ++lv) {
+        simd::forceLevel(static_cast<simd::Level>(lv));
+        size_t hits = 0;
+        double sec = secondsOf([&]() {
+            for (int r = 0; r < rounds; ++r) hits = simd::selectBetween(cols.dateKey.data(), flags.data(), 1, n, lo, hi, out.data());
+        });
+        string name = string("select/") + simd::levelName(simd::activeLevel());
+        report(name.c_str(), n * rounds, n * rounds * (sizeof(int32_t) + sizeof(uint8_t)), hits, sec);
+    }
+    return 0;
+}
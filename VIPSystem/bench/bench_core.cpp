@@ -0,0 +1,183 @@
+/*
+ * 核心路径基准：生成数据 -> 依次计时 加载 / 查找 / 消费 / 查询 / 保存
+ * 每项输出一行 JSON（方便脚本对比版本间回归）：
+ *   {"bench":"find_member","ops":200000,"ns_per_op":85.1,"ops_per_sec":11750000,"allocs_per_op":0.00,"bytes_per_op":0.0}
+ * 第一行是本次参数 {"meta":...}
+ *
+ * - load_members / load_transactions：ops = 行数（ns_per_op = 每行耗时）
+ * - find_member / get_member / purchase / query_member：会员号按 Zipf 抽样 预先生成 不计入时间
+ * - purchase：同步 VipService::purchase 日志组提交 4096 条（和批处理一致）
+ * - purchase_ingest：submitPurchase 入队 + 等全部 future 随后一行 purchase_ingest_latency 报告分位数
+ * - save_all：ops = 写出的会员 + 交易行数
+ * - allocs / bytes：本文件替换了全局 operator new 统计计时区间内的堆分配
+ *
+ * 编译：g++ -std=c++17 -O2 -pthread -I../src bench_core.cpp -o bench_core
+ * 运行：./bench_core [会员数 100000] [交易数 1000000] [Zipf 指数 1.1] [操作数 200000]
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <new>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "vip_service.h"
+#include "datagen.h"
+
+using namespace std;
+
+// ================== 分配计数 ==================
+
+static atomic<uint64_t> gAllocs{0};
+static atomic<uint64_t> gAllocBytes{0};
+
+// 这里的 new 就是 malloc 所以 delete 用 free 是配对的
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void* operator new(size_t n) {
+    gAllocs.fetch_add(1, memory_order_relaxed);
+    gAllocBytes.fetch_add(n, memory_order_relaxed);
+    if (void* p = malloc(n ? n : 1)) return p;
+    throw bad_alloc();
+}
+void* operator new[](size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+// ================== 计时 ==================
+
+static string gExtra; // 计时函数里设置 附加到本条结果（已经带前导逗号）
+
+template <typename Fn>
+static void bench(const char* name, uint64_t ops, Fn fn) {
+    uint64_t a0 = gAllocs.load();
+    uint64_t b0 = gAllocBytes.load();
+    auto t0 = chrono::steady_clock::now();
+    fn();
+    auto t1 = chrono::steady_clock::now();
+    uint64_t allocs = gAllocs.load() - a0;
+    uint64_t bytes = gAllocBytes.load() - b0;
+
+    double ns = chrono::duration<double, nano>(t1 - t0).count();
+    double n = ops ? static_cast<double>(ops) : 1.0;
+    printf("{\"bench\":\"%s\",\"ops\":%llu,\"ns_per_op\":%.1f,\"ops_per_sec\":%.0f,"
+           "\"allocs_per_op\":%.2f,\"bytes_per_op\":%.1f%s}\n",
+           name, static_cast<unsigned long long>(ops), ns / n, n / (ns / 1e9),
+           allocs / n, bytes / n, gExtra.c_str());
+    fflush(stdout);
+    gExtra.clear();
+}
+
+int main(int argc, char** argv) {
+    datagen::Options opt;
+    opt.members = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 100000;
+    opt.transactions = (argc > 2) ? strtoull(argv[2], nullptr, 10) : 1000000;
+    if (argc > 3) opt.skew = atof(argv[3]);
+    const uint64_t ops = (argc > 4) ? strtoull(argv[4], nullptr, 10) : 200000;
+    if (opt.members == 0 || opt.skew <= 0 || ops == 0) return 1;
+    opt.rowsPerDay = opt.transactions / 700 + 1;
+
+    char dirTemplate[] = "/tmp/vipbench.XXXXXX";
+    if (!mkdtemp(dirTemplate)) { perror("mkdtemp"); return 1; }
+    const string dir = dirTemplate;
+    const string memberPath = dir + "/members.txt";
+    const string transactionPath = dir + "/transactions.txt";
+    const string emptyPath = dir + "/empty.txt";
+
+    printf("{\"meta\":\"bench_core\",\"members\":%llu,\"transactions\":%llu,\"skew\":%.3f,\"ops\":%llu,"
+           "\"load_threads\":%u,\"scan\":\"%s\"}\n",
+           static_cast<unsigned long long>(opt.members), static_cast<unsigned long long>(opt.transactions),
+           opt.skew, static_cast<unsigned long long>(ops), loader::defaultThreadCount(),
+           simd::levelName(simd::activeLevel()));
+
+    bench("generate", opt.members + opt.transactions, [&]() {
+        if (!datagen::generate(opt, memberPath, transactionPath)) { perror("generate"); exit(1); }
+    });
+
+    // 单独加载会员 / 单独加载交易（另一边给一个不存在的文件）
+    {
+        VipService svc(memberPath, emptyPath, dir + "/j1.log");
+        bench("load_members", opt.members, [&]() { svc.loadAll(); });
+    }
+    {
+        VipService svc(emptyPath, transactionPath, dir + "/j2.log");
+        bench("load_transactions", opt.transactions, [&]() { svc.loadAll(); });
+    }
+
+    VipService svc(memberPath, transactionPath, dir + "/journal.log");
+    svc.loadAll();
+    svc.setJournalGroupSize(4096);
+
+    // 按 Zipf 热度抽会员号（热门会员被反复查询 / 消费）
+    datagen::Rng rng(opt.seed + 1);
+    datagen::Zipf zipf(opt.members, opt.skew);
+    vector<string> ids(ops);
+    for (uint64_t i = 0; i < ops; ++i) ids[i] = datagen::memberId(zipf.sample(rng) - 1);
+
+    {
+        size_t found = 0;
+        bench("find_member", ops, [&]() {
+            for (uint64_t i = 0; i < ops; ++i) found += svc.memberExists(ids[i]);
+        });
+        if (found != ops) fprintf(stderr, "find_member: %zu/%llu found\n", found, static_cast<unsigned long long>(ops));
+    }
+    {
+        MemberInfo info;
+        long long points = 0;
+        bench("get_member", ops, [&]() {
+            for (uint64_t i = 0; i < ops; ++i) if (svc.getMember(ids[i], info)) points += info.points;
+        });
+    }
+    {
+        size_t rows = 0;
+        Money sum;
+        bench("query_member", ops, [&]() {
+            for (uint64_t i = 0; i < ops; ++i) {
+                rows += svc.forEachMemberTransaction(ids[i], [&](const Transaction& t, const TransactionStore&) {
+                    sum += t.pay;
+                });
+            }
+            // 输出合计 循环不会被优化掉
+            gExtra = ",\"rows_visited\":" + to_string(rows) + ",\"pay_sum\":\"" + sum.toString() + "\"";
+        });
+    }
+    {
+        const string date = "2026-06-01";
+        const string item = "商品-1";
+        bench("purchase", ops, [&]() {
+            for (uint64_t i = 0; i < ops; ++i) svc.purchase(ids[i], date, item, Money::fromCents(1999));
+            svc.syncJournal();
+        });
+    }
+    {
+        vector<future<PurchaseResult>> results;
+        results.reserve(ops);
+        bench("purchase_ingest", ops, [&]() {
+            for (uint64_t i = 0; i < ops; ++i) {
+                results.push_back(svc.submitPurchase(ids[i], "2026-06-02", "商品-2", Money::fromCents(2999)));
+            }
+            for (size_t i = 0; i < results.size(); ++i) results[i].get();
+        });
+        // 入队到 future 兑现的延迟分布
+        IngestStats st = svc.ingestStats();
+        printf("{\"bench\":\"purchase_ingest_latency\",\"ops\":%llu,\"p50_ns\":%llu,\"p99_ns\":%llu,"
+               "\"p999_ns\":%llu,\"max_ns\":%llu,\"batches\":%llu}\n",
+               static_cast<unsigned long long>(st.latency.count), static_cast<unsigned long long>(st.latency.p50Ns),
+               static_cast<unsigned long long>(st.latency.p99Ns), static_cast<unsigned long long>(st.latency.p999Ns),
+               static_cast<unsigned long long>(st.latency.maxNs), static_cast<unsigned long long>(st.batches));
+        svc.stopIngest();
+    }
+
+    bench("save_all", svc.memberCount() + svc.transactionCount(), [&]() { svc.saveAll(); });
+
+    // 清理临时目录
+    const char* files[] = { "members.txt", "transactions.txt", "empty.txt", "j1.log", "j2.log", "journal.log" };
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i) unlink((dir + "/" + files[i]).c_str());
+    rmdir(dir.c_str());
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ * 扫描/切分 微基准：bytes/s 对比
+ * - splitByPipe：旧路径 getline + trim + splitByPipe（每行多次堆分配）
+ * - view/<level>：string_view 零分配路径 分别强制 scalar / sse2 / avx2 扫描
+ * - trim/<level>：定宽导出那种两边补了很多空格的字段 只测 trimView
+ *
+ * 编译：g++ -std=c++17 -O2 -pthread -I../src bench_scan.cpp -o bench_scan
+ * 运行：./bench_scan [MB 默认 64]
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "utility.h"
+#include "parallel_loader.h"
+#include "simd_scan.h"
+
+using namespace std;
+
+static string makeTransactionsText(size_t targetBytes) {
+    string data;
+    data.reserve(targetBytes + 128);
+    const char* items[] = { "未填写", "可乐", "男士衬衫 XL", "儿童玩具套装", "SKU-000123" };
+    srand(12345);
+    long id = 1;
+    char line[256];
+    while (data.size() < targetBytes) {
+        int m = rand() % 100000;
+        snprintf(line, sizeof(line), "%ld | M%06d | 2026-%02d-%02d | %s | %d.%02d | %d.%02d | %d\n",
+                 id++, m, 1 + rand() % 12, 1 + rand() % 28, items[rand() % 5],
+                 rand() % 5000, rand() % 100, rand() % 5000, rand() % 100, rand() % 500);
+        data += line;
+    }
+    return data;
+}
+
+template <typename Fn>
+static double secondsOf(Fn fn) {
+    auto t0 = chrono::steady_clock::now();
+    fn();
+    auto t1 = chrono::steady_clock::now();
+    return chrono::duration<double>(t1 - t0).count();
+}
+
+static void report(const char* name, size_t bytes, size_t fields, double sec) {
+    printf("%-16s %8.1f MB/s  fields=%zu  time=%.3fs\n", name, bytes / sec / 1e6, fields, sec);
+}
+
+int main(int argc, char** argv) {
+    size_t mb = (argc > 1) ? static_cast<size_t>(atoi(argv[1])) : 64;
+    string data = makeTransactionsText(mb << 20);
+
+    // 旧路径
+    {
+        size_t fields = 0;
+        double sec = secondsOf([&]() {
+            istringstream in(data);
+            string line;
+            while (getline(in, line)) {
+                line = util::trim(line);
+                if (line.empty()) continue;
+                vector<string> p = util::splitByPipe(line);
+                fields += p.size();
+            }
+        });
+        report("splitByPipe", data.size(), fields, sec);
+    }
+
+    // 新路径 逐级强制扫描实现
+    const simd::Level best = simd::activeLevel();
+    for (int lv = simd::kScalar; lv <= best; ++lv) {
+        simd::forceLevel(static_cast<simd::Level>(lv));
+        size_t fields = 0;
+        double sec = secondsOf([&]() {
+            loader::forEachLine(data.data(), data.data() + data.size(), [&](const char* b, const char* e) {
+                string_view line = util::trimView(string_view(b, static_cast<size_t>(e - b)));
+                if (line.empty()) return;
+                array<string_view, 7> f;
+                if (util::splitFields(line, f)) fields += f.size();
+            });
+        });
+        string name = string("view/") + simd::levelName(simd::activeLevel());
+        report(name.c_str(), data.size(), fields, sec);
+    }
+
+    // 定宽字段（左右各补 0~40 个空白 CRLF 结尾）
+    {
+        vector<string> padded;
+        srand(54321);
+        for (int i = 0; i < 200000; ++i) {
+            padded.push_back(string(rand() % 40, ' ') + "M" + to_string(rand() % 100000) + string(rand() % 40, ' ') + "\r");
+        }
+        for (int lv = simd::kScalar; lv <= best; ++lv) {
+            simd::forceLevel(static_cast<simd::Level>(lv));
+            size_t kept = 0, bytes = 0;
+            double sec = secondsOf([&]() {
+                for (int r = 0; r < 20; ++r) {
+                    for (size_t i = 0; i < padded.size(); ++i) {
+                        kept += util::trimView(padded[i]).size();
+                        bytes += padded[i].size();
+                    }
+                }
+            });
+            string name = string("trim/") + simd::levelName(simd::activeLevel());
+            report(name.c_str(), bytes, kept, sec);
+        }
+    }
+
+    // 纯换行扫描（大缓冲区里找记录边界）
+    for (int lv = simd::kScalar; lv <= best; ++lv) {
+        simd::forceLevel(static_cast<simd::Level>(lv));
+        size_t lines = 0;
+        double sec = secondsOf([&]() {
+            const char* p = data.data();
+            const char* end = p + data.size();
+            while (p < end) {
+                p = simd::findByte(p, end, '\n');
+                if (p < end) { ++lines; ++p; }
+            }
+        });
+        string name = string("newline/") + simd::levelName(simd::activeLevel());
+        report(name.c_str(), data.size(), lines, sec);
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * 回归检查：交易号跨重启只增不退（删除会员 + 封存 + 重新注册）
+ * 1) A1 消费一笔后封存；X 消费三笔（交易号 2~4）后删除 清单记 D | X | 5；checkpoint
+ * 2) 重启 X 重新注册并消费一笔 这笔的交易号必须 >= 5（快照里最大的交易号 1 属于 A1）再封存
+ * 3) 重启 X 的这笔消费还在（交易号 < 水位线会被当成已删除丢掉）
+ *
+ * 编译：g++ -std=c++17 -O2 -pthread -I../src check_txid.cpp -o check_txid
+ * 运行：./check_txid [临时目录 默认 mkdtemp]  通过返回 0
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+#include "vip_service.h"
+
+using namespace std;
+
+static int gFailures = 0;
+
+static void expect(bool cond, const char* what) {
+    printf("%s %s\n", cond ? "ok  " : "FAIL", what);
+    if (!cond) ++gFailures;
+}
+
+// 逐行执行 返回全部响应
+static string run(VipService& service, const char* const* lines) {
+    string response;
+    for (const char* const* p = lines; *p; ++p) {
+        bool ok = false;
+        service.executeLine(*p, response, ok);
+    }
+    return response;
+}
+
+int main(int argc, char** argv) {
+    char tmpl[] = "/tmp/check_txid.XXXXXX";
+    const string dir = (argc > 1) ? string(argv[1]) : string(mkdtemp(tmpl));
+    const string members = dir + "/members.txt";
+    const string transactions = dir + "/transactions.txt";
+    const string journal = dir + "/journal.log";
+
+    {
+        VipService service(members, transactions, journal);
+        expect(service.loadAll(), "首次加载");
+        static const char* const lines[] = {
+            "ADD | A1 | a | 1",
+            "BUY | A1 | 2025-01-01 | i | 10.00",
+            "SEAL | 2025-01-02",
+            "ADD | X | x | 1",
+            "BUY | X | 2025-01-03 | i | 1.00",
+            "BUY | X | 2025-01-04 | i | 1.00",
+            "BUY | X | 2025-01-05 | i | 1.00",
+            "DEL | X",
+            "CHECKPOINT",
+            nullptr
+        };
+        run(service, lines);
+        expect(service.nextTransactionId() == 5, "删除前已经用到交易号 4");
+    }
+    {
+        VipService service(members, transactions, journal);
+        expect(service.loadAll(), "第二次加载");
+        expect(service.nextTransactionId() >= 5, "重启后交易号不回退到快照里的最大值 + 1");
+        static const char* const lines[] = {
+            "ADD | X | x | 1",
+            "BUY | X | 2025-01-06 | i | 30.00",
+            "SEAL | 2025-01-07",
+            nullptr
+        };
+        run(service, lines);
+    }
+    {
+        VipService service(members, transactions, journal);
+        expect(service.loadAll(), "第三次加载");
+        MemberInfo info;
+        MemberAggregate agg;
+        expect(service.getMemberSummary("X", info, agg), "X 存在");
+        expect(agg.count == 1 && agg.pay == Money::fromCents(3000), "X 重新注册后封存的消费没有被当成已删除");
+    }
+
+    printf("%s（目录 %s）\n", gFailures == 0 ? "通过" : "失败", dir.c_str());
+    return gFailures == 0 ? 0 : 1;
+}
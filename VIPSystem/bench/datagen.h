@@ -0,0 +1,198 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <charconv>
+#include <string>
+#include <vector>
+
+#include "money.h"
+#include "functors.h"
+
+using namespace std;
+
+/*
+ * 合成数据：members.txt / transactions.txt（格式和 src 里的 loadMembers / loadTransactions 一致）
+ * - 会员热度服从 Zipf(s)：排名 1 的会员最常消费（真实商场里少数老会员贡献大部分流水）
+ * - 商品同样服从 Zipf 从 kItemCount 个商品里抽
+ * - 交易按日期递增（2025-01-01 起 每天 rowsPerDay 条左右）
+ * - 实付 / 积分用和系统相同的折扣与 PointsCalculator 计算 会员积分 = 其交易积分之和
+ * 规模 1e3 ~ 1e8 行：逐行 to_chars 拼进 1MB 缓冲区 fwrite 不经过 iostream
+ */
+
+namespace datagen {
+
+    // xorshift64*：快、可复现
+    struct Rng {
+        uint64_t s;
+        explicit Rng(uint64_t seed) : s(seed ? seed : 0x9E3779B97F4A7C15ULL) {}
+        uint64_t next() {
+            s ^= s >> 12; s ^= s << 25; s ^= s >> 27;
+            return s * 0x2545F4914F6CDD1DULL;
+        }
+        double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+        uint64_t below(uint64_t n) { return next() % n; }
+    };
+
+    // Zipf 采样（拒绝-反演法 Hörmann & Derflinger）O(1) 每次 不需要 n 大小的表 1e8 也能用
+    // 返回 [1, n] 的排名
+    class Zipf {
+    private:
+        double mS;
+        double mN;
+        double mHx1;
+        double mHn;
+        double mSDiv;
+
+        static double helper1(double x) { return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x)); }
+        static double helper2(double x) { return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x * 0.5 * (1 + x * (1.0 / 3) * (1 + 0.25 * x)); }
+        double h(double x) const { return exp(-mS * log(x)); }
+        double hIntegral(double x) const { double lx = log(x); return helper2((1 - mS) * lx) * lx; }
+        double hIntegralInverse(double x) const {
+            double t = x * (1 - mS);
+            if (t < -1) t = -1;
+            return exp(helper1(t) * x);
+        }
+
+    public:
+        Zipf(uint64_t n, double s) : mS(s), mN(static_cast<double>(n)) {
+            mHx1 = hIntegral(1.5) - 1;
+            mHn = hIntegral(mN + 0.5);
+            mSDiv = 2 - hIntegralInverse(hIntegral(2.5) - h(2));
+        }
+
+        uint64_t sample(Rng& rng) const {
+            while (true) {
+                double u = mHn + rng.uniform() * (mHx1 - mHn);
+                double x = hIntegralInverse(u);
+                double k = floor(x + 0.5);
+                if (k < 1) k = 1;
+                else if (k > mN) k = mN;
+                if (k - x <= mSDiv || u >= hIntegral(k + 0.5) - h(k)) return static_cast<uint64_t>(k);
+            }
+        }
+    };
+
+    static const unsigned kItemCount = 200;
+
+    inline int levelOf(uint64_t memberIndex) {
+        if (memberIndex % 10 == 0) return 2;  // SVIP
+        if (memberIndex % 5 == 0) return 1;   // VIP
+        return 0;
+    }
+
+    inline int discountOf(int level) { return level == 2 ? 85 : (level == 1 ? 95 : 100); }
+
+    // M00000001 形式 定长 方便 bench 直接拼
+    inline string memberId(uint64_t index) {
+        char buf[24];
+        snprintf(buf, sizeof(buf), "M%08llu", static_cast<unsigned long long>(index));
+        return buf;
+    }
+
+    // 1MB 缓冲的 FILE 写入
+    class Writer {
+    private:
+        FILE*  mFile;
+        string mBuf;
+
+    public:
+        explicit Writer(const string& path) : mFile(fopen(path.c_str(), "wb")) { mBuf.reserve(1 << 20); }
+        ~Writer() { flush(); if (mFile) fclose(mFile); }
+        bool ok() const { return mFile != nullptr; }
+        void flush() {
+            if (mFile && !mBuf.empty()) fwrite(mBuf.data(), 1, mBuf.size(), mFile);
+            mBuf.clear();
+        }
+        Writer& str(const char* s, size_t n) { mBuf.append(s, n); if (mBuf.size() >= (1 << 20)) flush(); return *this; }
+        Writer& str(const string& s) { return str(s.data(), s.size()); }
+        Writer& str(const char* s) { return str(s, strlen(s)); }
+        Writer& num(long long v) {
+            char b[24];
+            return str(b, static_cast<size_t>(to_chars(b, b + sizeof(b), v).ptr - b));
+        }
+        Writer& money(Money m) {
+            char b[32];
+            return str(b, static_cast<size_t>(m.format(b) - b));
+        }
+    };
+
+    // 公历天数 -> YYYY-MM-DD（从 2025-01-01 起）
+    inline void dateOf(long day, char out[11]) {
+        static const int kDays[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        int y = 2025;
+        while (true) {
+            bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+            int len = leap ? 366 : 365;
+            if (day < len) break;
+            day -= len;
+            ++y;
+        }
+        bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+        int m = 0;
+        while (true) {
+            int len = kDays[m] + (m == 1 && leap ? 1 : 0);
+            if (day < len) break;
+            day -= len;
+            ++m;
+        }
+        int d = static_cast<int>(day) + 1;
+        ++m;
+        const char v[10] = { char('0' + y / 1000), char('0' + y / 100 % 10), char('0' + y / 10 % 10), char('0' + y % 10), '-',
+                             char('0' + m / 10), char('0' + m % 10), '-', char('0' + d / 10), char('0' + d % 10) };
+        memcpy(out, v, 10);
+        out[10] = '\0';
+    }
+
+    struct Options {
+        uint64_t members = 100000;
+        uint64_t transactions = 1000000;
+        double   skew = 1.1;          // Zipf 指数 越大越集中
+        uint64_t rowsPerDay = 5000;
+        uint64_t seed = 20260101;
+    };
+
+    // 写 members.txt / transactions.txt 失败返回 false
+    inline bool generate(const Options& opt, const string& memberPath, const string& transactionPath) {
+        Rng rng(opt.seed);
+        Zipf memberZipf(opt.members, opt.skew);
+        Zipf itemZipf(kItemCount, 1.0);
+        functor::PointsCalculator points;
+        vector<int> memberPoints(opt.members, 0);
+
+        {
+            Writer out(transactionPath);
+            if (!out.ok()) return false;
+            char date[11];
+            long lastDay = -1;
+            for (uint64_t i = 0; i < opt.transactions; ++i) {
+                long day = static_cast<long>(i / (opt.rowsPerDay ? opt.rowsPerDay : 1));
+                if (day != lastDay) { dateOf(day, date); lastDay = day; }
+
+                uint64_t m = memberZipf.sample(rng) - 1;
+                uint64_t item = itemZipf.sample(rng);
+                Money amount = Money::fromCents(static_cast<long long>(100 + rng.below(99900)));
+                Money pay = amount.applyPercent(discountOf(levelOf(m)));
+                int earned = points(pay);
+                memberPoints[m] += earned;
+
+                // transactionId | memberId | date | item | amount | pay | pointsEarned
+                out.num(static_cast<long long>(i + 1)).str(" | ").str(memberId(m)).str(" | ")
+                   .str(date, 10).str(" | ").str("商品-").num(static_cast<long long>(item)).str(" | ")
+                   .money(amount).str(" | ").money(pay).str(" | ").num(earned).str("\n");
+            }
+        }
+
+        Writer out(memberPath);
+        if (!out.ok()) return false;
+        for (uint64_t m = 0; m < opt.members; ++m) {
+            // id | name | phone | level | points | joinDate
+            out.str(memberId(m)).str(" | 会员").num(static_cast<long long>(m)).str(" | 138")
+               .num(static_cast<long long>(10000000 + m % 90000000)).str(" | ").num(levelOf(m)).str(" | ")
+               .num(memberPoints[m]).str(" | 2024-12-01\n");
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,175 @@
+/*
+ * 服务端压测客户端：N 个连接并发 每个连接流水线发送 BUY / QUERY 报告 requests/s
+ * - 先用一个连接 ADD 会员 L0000..（已存在会回 ERR 不影响）
+ * - 每个连接：一次写出 pipeline 条命令 收齐同样多条回应再发下一批
+ * - 每 10 条里 1 条 QUERY 其余 BUY
+ *
+ * 编译：g++ -std=c++17 -O2 -pthread -I../src load_client.cpp -o load_client
+ * 运行：../src/proc --serve unix:/tmp/vip.sock   （另一个终端）
+ *       ./load_client unix:/tmp/vip.sock [连接数 4] [每连接请求数 100000] [流水线深度 32] [会员数 1000]
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+using namespace std;
+
+static int connectTo(const string& address) {
+    if (address.compare(0, 5, "unix:") == 0) {
+        string path = address.substr(5);
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path)) return -1;
+        memcpy(addr.sun_path, path.c_str(), path.size());
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            if (fd >= 0) close(fd);
+            return -1;
+        }
+        return fd;
+    }
+    if (address.compare(0, 4, "tcp:") == 0) {
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(atoi(address.c_str() + 4)));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            if (fd >= 0) close(fd);
+            return -1;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        return fd;
+    }
+    return -1;
+}
+
+static bool writeAll(int fd, const string& data) {
+    size_t pos = 0;
+    while (pos < data.size()) {
+        ssize_t n = send(fd, data.data() + pos, data.size() - pos, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        pos += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// 收齐 count 行回应 统计 OK / ERR
+struct LineReader {
+    int    fd;
+    string buf;
+
+    bool readLines(size_t count, size_t& ok, size_t& err) {
+        char tmp[64 * 1024];
+        size_t start = 0;
+        while (count > 0) {
+            size_t nl = buf.find('\n', start);
+            if (nl == string::npos) {
+                buf.erase(0, start);
+                start = 0;
+                ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+                if (n <= 0) return false;
+                buf.append(tmp, static_cast<size_t>(n));
+                continue;
+            }
+            if (buf.compare(start, 2, "OK") == 0) ++ok;
+            else ++err;
+            start = nl + 1;
+            --count;
+        }
+        buf.erase(0, start);
+        return true;
+    }
+};
+
+static string memberId(unsigned i) {
+    char id[16];
+    snprintf(id, sizeof(id), "L%04u", i);
+    return id;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "用法：%s <unix:/path|tcp:PORT> [连接数] [每连接请求数] [流水线深度] [会员数]\n", argv[0]);
+        return 1;
+    }
+    const string address = argv[1];
+    const unsigned connections = (argc > 2) ? static_cast<unsigned>(atoi(argv[2])) : 4;
+    const size_t requests = (argc > 3) ? static_cast<size_t>(atol(argv[3])) : 100000;
+    const size_t pipeline = (argc > 4) ? static_cast<size_t>(atol(argv[4])) : 32;
+    const unsigned members = (argc > 5) ? static_cast<unsigned>(atoi(argv[5])) : 1000;
+    if (connections == 0 || pipeline == 0 || members == 0) return 1;
+
+    // 准备会员
+    {
+        int fd = connectTo(address);
+        if (fd < 0) { perror("connect"); return 1; }
+        string req;
+        for (unsigned i = 0; i < members; ++i) req += "ADD | " + memberId(i) + " | 压测 | 000 | " + to_string(i % 3) + "\n";
+        LineReader reader{fd, string()};
+        size_t ok = 0, err = 0;
+        if (!writeAll(fd, req) || !reader.readLines(members, ok, err)) { fprintf(stderr, "准备会员失败\n"); return 1; }
+        close(fd);
+    }
+
+    atomic<size_t> totalOk{0};
+    atomic<size_t> totalErr{0};
+    atomic<bool> failed{false};
+
+    auto t0 = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (unsigned c = 0; c < connections; ++c) {
+        threads.emplace_back([&, c]() {
+            int fd = connectTo(address);
+            if (fd < 0) { failed = true; return; }
+            LineReader reader{fd, string()};
+            unsigned seed = 12345u + c;
+            size_t ok = 0, err = 0;
+            string req;
+            for (size_t sent = 0; sent < requests;) {
+                size_t n = min(pipeline, requests - sent);
+                req.clear();
+                for (size_t i = 0; i < n; ++i) {
+                    seed = seed * 1103515245u + 12345u;
+                    string id = memberId((seed >> 8) % members);
+                    char line[128];
+                    if ((sent + i) % 10 == 9) {
+                        snprintf(line, sizeof(line), "QUERY | %s\n", id.c_str());
+                    } else {
+                        snprintf(line, sizeof(line), "BUY | %s | 2026-03-%02u | 压测商品 | %u.50\n",
+                                 id.c_str(), 1 + (seed >> 4) % 28, (seed >> 12) % 500);
+                    }
+                    req += line;
+                }
+                if (!writeAll(fd, req) || !reader.readLines(n, ok, err)) { failed = true; break; }
+                sent += n;
+            }
+            close(fd);
+            totalOk += ok;
+            totalErr += err;
+        });
+    }
+    for (size_t i = 0; i < threads.size(); ++i) threads[i].join();
+    double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    size_t done = totalOk + totalErr;
+    printf("connections=%u pipeline=%zu requests=%zu ok=%zu err=%zu time=%.3fs  %.0f req/s%s\n",
+           connections, pipeline, done, totalOk.load(), totalErr.load(), sec, done / sec,
+           failed ? "  (有连接异常中断)" : "");
+    return failed ? 1 : 0;
+}
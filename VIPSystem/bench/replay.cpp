@@ -0,0 +1,263 @@
+/*
+ * 端到端回放：把一份带时间戳的操作序列（消费 / 查询 / 修改 / 删除）打到 VipService 上
+ * 报告持续吞吐和 p50/p99/p999 延迟（总体 + 按命令类型）每项一行 JSON
+ *
+ * 负载文件：一行一条 第一个字段是相对开始的微秒数 后面就是 command.h 的文本命令
+ *   1520 | BUY | M00000003 | 2026-11-11 | 商品-7 | 199.00
+ *   1733 | QUERY | M00000001
+ * 生成负载：./replay --generate <文件> <操作数> [会员数 10000] [每秒 20000] [Zipf 1.1]
+ *   Poisson 到达 会员按 Zipf 热度 约 80% BUY 15% QUERY 4% EDIT 1% DEL+ADD
+ *
+ * 回放：./replay <负载文件> [--threads N] [--closed] [--rate R] [--data 目录]
+ * - 开环（默认）：按时间戳发（--rate 把整体速率缩放到 R 条/秒）
+ *   延迟 = 完成时刻 - 计划时刻 包含排队（落后于计划时不会把延迟藏起来）
+ * - 闭环 --closed：不看时间戳 每个线程做完一条马上下一条 测最大吞吐
+ * - 同一会员的操作总是分给同一个线程（按会员号哈希）保证单会员内的先后顺序
+ * - --data 指定已有 members.txt / transactions.txt（只读 日志写到临时目录 不做 checkpoint）
+ *   不指定时按负载里的会员数生成一份 10 倍会员数的交易快照
+ *
+ * 编译：g++ -std=c++17 -O2 -pthread -I../src replay.cpp -o replay
+ */
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "vip_service.h"
+#include "histogram.h"
+#include "datagen.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+// ================== 生成负载 ==================
+
+static int generateWorkload(const string& path, uint64_t ops, uint64_t members, double rate, double skew) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) { perror(path.c_str()); return 1; }
+
+    datagen::Rng rng(20261111);
+    datagen::Zipf zipf(members, skew);
+    // 第一行注释里记下会员数 回放时据此生成快照
+    fprintf(f, "# members=%llu\n", static_cast<unsigned long long>(members));
+
+    double t = 0;
+    for (uint64_t i = 0; i < ops; ++i) {
+        t += -log(1.0 - rng.uniform()) / rate * 1e6;  // Poisson 到达间隔（微秒）
+        uint64_t m = zipf.sample(rng) - 1;
+        string id = datagen::memberId(m);
+        unsigned long long us = static_cast<unsigned long long>(t);
+        unsigned r = static_cast<unsigned>(rng.below(100));
+        if (r < 80) {
+            fprintf(f, "%llu | BUY | %s | 2026-11-%02u | 商品-%llu | %llu.%02llu\n", us, id.c_str(),
+                    1 + static_cast<unsigned>(rng.below(11)), static_cast<unsigned long long>(rng.below(200) + 1),
+                    static_cast<unsigned long long>(rng.below(1000)), static_cast<unsigned long long>(rng.below(100)));
+        } else if (r < 95) {
+            fprintf(f, "%llu | QUERY | %s\n", us, id.c_str());
+        } else if (r < 99) {
+            fprintf(f, "%llu | EDIT | %s | | 139%08llu\n", us, id.c_str(), static_cast<unsigned long long>(rng.below(100000000)));
+        } else {
+            // 删了马上重新入会 会员总数不变
+            fprintf(f, "%llu | DEL | %s\n", us, id.c_str());
+            fprintf(f, "%llu | ADD | %s | 回流会员 | 000 | %d\n", us, id.c_str(), datagen::levelOf(m));
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+// ================== 回放 ==================
+
+struct Op {
+    uint64_t atUs;    // 计划时刻（相对开始）
+    int      kind;    // 下标见 kKinds
+    string   command;
+};
+
+static const char* kKinds[] = { "BUY", "QUERY", "EDIT", "DEL", "ADD", "OTHER" };
+static const int kKindCount = 6;
+
+static int kindOf(string_view cmd) {
+    for (int k = 0; k < kKindCount - 1; ++k) {
+        size_t n = strlen(kKinds[k]);
+        if (cmd.size() >= n && cmd.compare(0, n, kKinds[k]) == 0) return k;
+    }
+    return kKindCount - 1;
+}
+
+struct ThreadResult {
+    LatencyHistogram all;
+    LatencyHistogram byKind[kKindCount];
+    uint64_t errors = 0;
+    uint64_t maxLagUs = 0;   // 开环：开始执行时最多落后计划多少
+};
+
+static void printLatency(const char* name, const LatencyHistogram& h) {
+    printf("{\"latency\":\"%s\",\"ops\":%llu,\"mean_ns\":%llu,\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,\"max_ns\":%llu}\n",
+           name, static_cast<unsigned long long>(h.count()), static_cast<unsigned long long>(h.mean()),
+           static_cast<unsigned long long>(h.percentile(0.50)), static_cast<unsigned long long>(h.percentile(0.99)),
+           static_cast<unsigned long long>(h.percentile(0.999)), static_cast<unsigned long long>(h.max()));
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 4 && strcmp(argv[1], "--generate") == 0) {
+        uint64_t ops = strtoull(argv[3], nullptr, 10);
+        uint64_t members = (argc > 4) ? strtoull(argv[4], nullptr, 10) : 10000;
+        double rate = (argc > 5) ? atof(argv[5]) : 20000;
+        double skew = (argc > 6) ? atof(argv[6]) : 1.1;
+        if (members == 0 || rate <= 0 || skew <= 0) return 1;
+        return generateWorkload(argv[2], ops, members, rate, skew);
+    }
+    if (argc < 2) {
+        fprintf(stderr, "用法：%s <负载文件> [--threads N] [--closed] [--rate R] [--data 目录]\n"
+                        "      %s --generate <文件> <操作数> [会员数] [每秒] [Zipf]\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    unsigned threads = 4;
+    bool closedLoop = false;
+    double rate = 0;          // 0 = 按文件里的时间戳
+    string dataDir;
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = static_cast<unsigned>(atoi(argv[++i]));
+        else if (strcmp(argv[i], "--closed") == 0) closedLoop = true;
+        else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) rate = atof(argv[++i]);
+        else if (strcmp(argv[i], "--data") == 0 && i + 1 < argc) dataDir = argv[++i];
+    }
+    if (threads == 0) threads = 1;
+
+    // 读负载 按会员号分给线程
+    string text;
+    if (!loader::readWholeFile(argv[1], text)) { perror(argv[1]); return 1; }
+    uint64_t members = 10000;
+    vector<vector<Op>> perThread(threads);
+    uint64_t total = 0;
+    uint64_t lastUs = 0;
+    loader::forEachLine(text.data(), text.data() + text.size(), [&](const char* b, const char* e) {
+        string_view line = util::trimView(string_view(b, static_cast<size_t>(e - b)));
+        if (line.empty()) return;
+        if (line[0] == '#') {
+            size_t p = line.find("members=");
+            if (p != string_view::npos) members = strtoull(string(line.substr(p + 8)).c_str(), nullptr, 10);
+            return;
+        }
+        size_t bar = line.find('|');
+        if (bar == string_view::npos) return;
+        Op op;
+        op.atUs = static_cast<uint64_t>(util::parseLong(line.substr(0, bar)));
+        op.command = string(util::trimView(line.substr(bar + 1)));
+        op.kind = kindOf(op.command);
+
+        string_view fields[3];
+        size_t n = util::splitByPipeView(op.command, fields, 3);
+        size_t owner = (n >= 2) ? hash<string_view>()(fields[1]) % threads : total % threads;
+        if (op.atUs > lastUs) lastUs = op.atUs;
+        perThread[owner].push_back(std::move(op));
+        ++total;
+    });
+    if (total == 0) { fprintf(stderr, "负载为空\n"); return 1; }
+
+    // 数据：临时目录放日志（以及生成的快照）
+    char dirTemplate[] = "/tmp/vipreplay.XXXXXX";
+    if (!mkdtemp(dirTemplate)) { perror("mkdtemp"); return 1; }
+    const string tmp = dirTemplate;
+    string memberPath = dataDir + "/members.txt";
+    string transactionPath = dataDir + "/transactions.txt";
+    if (dataDir.empty()) {
+        datagen::Options opt;
+        opt.members = members;
+        opt.transactions = members * 10;
+        opt.rowsPerDay = opt.transactions / 700 + 1;
+        memberPath = tmp + "/members.txt";
+        transactionPath = tmp + "/transactions.txt";
+        if (!datagen::generate(opt, memberPath, transactionPath)) { perror("generate"); return 1; }
+    }
+
+    VipService svc(memberPath, transactionPath, tmp + "/journal.log");
+    svc.loadAll();
+    svc.setJournalGroupSize(4096);
+
+    // 按 --rate 缩放时间戳
+    const double scale = (rate > 0 && lastUs > 0) ? (static_cast<double>(total) / rate * 1e6) / lastUs : 1.0;
+
+    vector<ThreadResult> results(threads);
+    atomic<unsigned> ready{0};
+    atomic<bool> go{false};
+    Clock::time_point start;
+
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            ThreadResult& res = results[t];
+            string response;
+            ++ready;
+            while (!go.load(memory_order_acquire)) this_thread::yield();
+
+            for (const Op& op : perThread[t]) {
+                Clock::time_point planned = start;
+                if (!closedLoop) {
+                    planned = start + chrono::microseconds(static_cast<uint64_t>(op.atUs * scale));
+                    Clock::time_point now = Clock::now();
+                    if (now < planned) {
+                        // 远的先睡 最后 200us 自旋 减少唤醒误差
+                        if (planned - now > chrono::microseconds(200)) this_thread::sleep_until(planned - chrono::microseconds(200));
+                        while (Clock::now() < planned) {}
+                    } else {
+                        uint64_t lag = static_cast<uint64_t>(chrono::duration_cast<chrono::microseconds>(now - planned).count());
+                        if (lag > res.maxLagUs) res.maxLagUs = lag;
+                    }
+                }
+                Clock::time_point begin = closedLoop ? Clock::now() : planned;
+
+                response.clear();
+                bool ok = true;
+                svc.executeLine(op.command, response, ok);
+                if (!ok) ++res.errors;
+
+                uint64_t ns = static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(Clock::now() - begin).count());
+                res.all.record(ns);
+                res.byKind[op.kind].record(ns);
+            }
+        });
+    }
+    while (ready.load() < threads) this_thread::yield();
+    start = Clock::now();
+    go.store(true, memory_order_release);
+    for (size_t i = 0; i < workers.size(); ++i) workers[i].join();
+    svc.syncJournal();
+    double sec = chrono::duration<double>(Clock::now() - start).count();
+
+    ThreadResult sum;
+    for (unsigned t = 0; t < threads; ++t) {
+        sum.all.merge(results[t].all);
+        for (int k = 0; k < kKindCount; ++k) sum.byKind[k].merge(results[t].byKind[k]);
+        sum.errors += results[t].errors;
+        if (results[t].maxLagUs > sum.maxLagUs) sum.maxLagUs = results[t].maxLagUs;
+    }
+
+    double targetRate = closedLoop ? 0 : (rate > 0 ? rate : (lastUs ? total / (lastUs / 1e6) : 0));
+    printf("{\"replay\":\"%s\",\"mode\":\"%s\",\"threads\":%u,\"ops\":%llu,\"errors\":%llu,\"seconds\":%.3f,"
+           "\"ops_per_sec\":%.0f,\"target_ops_per_sec\":%.0f,\"max_lag_us\":%llu}\n",
+           argv[1], closedLoop ? "closed" : "open", threads, static_cast<unsigned long long>(total),
+           static_cast<unsigned long long>(sum.errors), sec, total / sec, targetRate,
+           static_cast<unsigned long long>(sum.maxLagUs));
+    printLatency("all", sum.all);
+    for (int k = 0; k < kKindCount; ++k) {
+        if (sum.byKind[k].count()) printLatency(kKinds[k], sum.byKind[k]);
+    }
+
+    // 清理临时目录（--data 的原文件不动）
+    unlink((tmp + "/journal.log").c_str());
+    unlink((tmp + "/members.txt").c_str());
+    unlink((tmp + "/transactions.txt").c_str());
+    rmdir(tmp.c_str());
+    return 0;
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <array>
+#include <algorithm>
+#include <cstdio>
+
+#include "segment.h"
+#include "durable_file.h"
+#include "utility.h"
+
+using namespace std;
+
+/*
+ * 交易归档：段文件清单（manifest）+ 已删除会员的水位线
+ * - 段文件和清单都放在 transactions.txt 旁边：<交易文件>.seg000001 ... / <交易文件>.manifest
+ * - 清单是文本 每行一条 整体写临时文件 fsync 再 rename + 目录 fsync（清单落盘 = 封存生效）
+ *     S | 文件名 | 行数 | 最小 dateKey | 最大 dateKey | 最小交易号 | 最大交易号
+ *     D | 会员号 | 水位线
+ * - 段文件不可修改 删除会员只在清单里记一笔：段里该会员 交易号 < 水位线 的行加载时丢弃
+ *   （同一个号后来重新注册 新交易的交易号一定 >= 水位线 不受影响：交易号只增不退
+ *    启动时不低于 nextTransactionIdFloor 和 checkpoint 记下的水位线 见 VipService::loadAll）
+ * 本身不加锁 由 VipService 的交易存储锁保护
+ */
+
+class TransactionArchive {
+public:
+    struct SegmentInfo {
+        string          file;     // 不含目录
+        segment::Header header;
+    };
+
+private:
+    string                       mPrefix;     // 交易文件路径
+    vector<SegmentInfo>          mSegments;
+    map<string, long, less<>>    mDeleted;    // 会员号 -> 水位线（less<> 可以直接拿 string_view 查）
+    bool                         mDirty = false;
+
+    string dir() const {
+        size_t slash = mPrefix.rfind('/');
+        return slash == string::npos ? string() : mPrefix.substr(0, slash + 1);
+    }
+
+public:
+    explicit TransactionArchive(const string& transactionFilePath) : mPrefix(transactionFilePath) {}
+
+    const vector<SegmentInfo>& segments() const { return mSegments; }
+    bool empty() const { return mSegments.empty(); }
+    string pathOf(const string& file) const { return dir() + file; }
+    string manifestPath() const { return mPrefix + ".manifest"; }
+    bool dirty() const { return mDirty; }
+
+    uint64_t rows() const {
+        uint64_t n = 0;
+        for (size_t i = 0; i < mSegments.size(); ++i) n += mSegments[i].header.rows;
+        return n;
+    }
+
+    // 下一个段文件名（段只增不删 编号 = 段数 + 1）
+    string nextSegmentFile() const {
+        string base = mPrefix.substr(dir().size());
+        char buf[16];
+        snprintf(buf, sizeof(buf), ".seg%06zu", mSegments.size() + 1);
+        return base + buf;
+    }
+
+    void addSegment(const string& file, const segment::Header& header) {
+        SegmentInfo s;
+        s.file = file;
+        s.header = header;
+        mSegments.push_back(s);
+        mDirty = true;
+    }
+
+    // 清单没写成功时撤销刚加的段
+    void dropLastSegment() {
+        if (!mSegments.empty()) mSegments.pop_back();
+    }
+
+    // 没有段时不用记（文本快照里的行删了就没了）
+    void recordDelete(const string& memberId, long watermark) {
+        if (mSegments.empty()) return;
+        long& w = mDeleted[memberId];
+        if (watermark > w) w = watermark;
+        mDirty = true;
+    }
+
+    // 该会员 交易号 < 返回值 的归档行已删除（没删过返回 0）
+    // 加载段时按段内字典每个会员号查一次 不是每行查一次
+    long deleteWatermark(string_view memberId) const {
+        if (mDeleted.empty()) return 0;
+        auto it = mDeleted.find(memberId);
+        return it == mDeleted.end() ? 0 : it->second;
+    }
+
+    // 清单能证明已经用过的交易号之后的第一个：段里最大的交易号 + 1 / 删除水位线 取大的
+    // 删除会员后文本快照里可能已经没有最大的那些交易号 不能只看快照
+    long nextTransactionIdFloor() const {
+        long floor = 1;
+        for (size_t i = 0; i < mSegments.size(); ++i) floor = max(floor, mSegments[i].header.maxTransactionId + 1);
+        for (auto it = mDeleted.begin(); it != mDeleted.end(); ++it) floor = max(floor, it->second);
+        return floor;
+    }
+
+    void clear() {
+        mSegments.clear();
+        mDeleted.clear();
+        mDirty = false;
+    }
+
+    // 清单不存在 = 还没有归档
+    void loadManifest() {
+        clear();
+        string data;
+        if (!loader::readWholeFile(manifestPath(), data)) return;
+        loader::forEachLine(data.data(), data.data() + data.size(), [&](const char* b, const char* e) {
+            string_view line = util::trimView(string_view(b, static_cast<size_t>(e - b)));
+            if (line.size() < 4 || line[1] != ' ' || line[2] != '|') return;
+            string_view body = line.substr(4);
+            if (line[0] == 'S') {
+                array<string_view, 6> f;
+                if (!util::splitFields(body, f)) return;
+                SegmentInfo s;
+                s.file = string(f[0]);
+                s.header.rows = static_cast<uint64_t>(util::parseLong(f[1]));
+                s.header.minDateKey = util::parseInt(f[2]);
+                s.header.maxDateKey = util::parseInt(f[3]);
+                s.header.minTransactionId = util::parseLong(f[4]);
+                s.header.maxTransactionId = util::parseLong(f[5]);
+                mSegments.push_back(s);
+            } else if (line[0] == 'D') {
+                array<string_view, 2> f;
+                if (!util::splitFields(body, f)) return;
+                mDeleted[string(f[0])] = util::parseLong(f[1]);
+            }
+        });
+    }
+
+    // 整个清单写到 path（不 rename）checkpoint 时交给 CheckpointManifest 和其他快照一起提交 见 checkpoint.h
+    bool writeManifest(const string& path) const {
+        ofstream fout(path.c_str());
+        if (!fout) return false;
+        for (size_t i = 0; i < mSegments.size(); ++i) {
+            const segment::Header& h = mSegments[i].header;
+            fout << "S | " << mSegments[i].file << " | " << h.rows << " | " << h.minDateKey << " | "
+                 << h.maxDateKey << " | " << h.minTransactionId << " | " << h.maxTransactionId << "\n";
+        }
+        for (auto it = mDeleted.begin(); it != mDeleted.end(); ++it) {
+            fout << "D | " << it->first << " | " << it->second << "\n";
+        }
+        return static_cast<bool>(fout.flush());
+    }
+
+    // writeManifest 写的临时文件已经提交
+    void markSaved() { mDirty = false; }
+
+    // 单独重写清单（封存生效）有改动才写 返回 true 时清单已经在盘上 失败返回 false
+    bool saveManifest() {
+        if (!mDirty) return true;
+        const string tmp = manifestPath() + ".tmp";
+        if (!writeManifest(tmp)) return false;
+        if (!durable::replaceFile(tmp, manifestPath())) return false;
+        mDirty = false;
+        return true;
+    }
+};
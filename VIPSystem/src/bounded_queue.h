@@ -0,0 +1,72 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <utility>
+
+using namespace std;
+
+/*
+ * 有界阻塞队列（多生产者多消费者 一把锁 + 两个条件变量）
+ * - push：满了就等 上游跑得快时自然被下游拖住（背压）内存占用有上限
+ * - pop：空了就等 close 之后取完剩下的返回 false
+ * - close：不再接收新元素 唤醒所有等待者（生产者的 push 返回 false）
+ *
+ * 元素是整块数据（一块文本 / 一块解析好的行）一次加锁摊到成千上万行上 锁不是瓶颈
+ * 逐条的低延迟场景用 mpsc_queue.h
+ */
+
+template <typename T>
+class BoundedQueue {
+private:
+    mutable mutex      mMutex;
+    condition_variable mNotFull;
+    condition_variable mNotEmpty;
+    deque<T>           mItems;
+    size_t             mCapacity;
+    bool               mClosed = false;
+
+private:
+    BoundedQueue(const BoundedQueue&);
+    BoundedQueue& operator=(const BoundedQueue&);
+
+public:
+    explicit BoundedQueue(size_t capacity) : mCapacity(capacity == 0 ? 1 : capacity) {}
+
+    // 已关闭返回 false（v 没有入队）
+    bool push(T v) {
+        unique_lock<mutex> lock(mMutex);
+        mNotFull.wait(lock, [&]() { return mClosed || mItems.size() < mCapacity; });
+        if (mClosed) return false;
+        mItems.push_back(std::move(v));
+        lock.unlock();
+        mNotEmpty.notify_one();
+        return true;
+    }
+
+    // 关闭且取空后返回 false
+    bool pop(T& out) {
+        unique_lock<mutex> lock(mMutex);
+        mNotEmpty.wait(lock, [&]() { return mClosed || !mItems.empty(); });
+        if (mItems.empty()) return false;
+        out = std::move(mItems.front());
+        mItems.pop_front();
+        lock.unlock();
+        mNotFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        {
+            lock_guard<mutex> lock(mMutex);
+            mClosed = true;
+        }
+        mNotFull.notify_all();
+        mNotEmpty.notify_all();
+    }
+
+    size_t size() const {
+        lock_guard<mutex> lock(mMutex);
+        return mItems.size();
+    }
+};
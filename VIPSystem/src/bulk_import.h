@@ -0,0 +1,289 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <utility>
+#include <cstdio>
+#include <cstring>
+
+#include "bounded_queue.h"
+#include "parallel_loader.h"
+#include "money.h"
+#include "utility.h"
+
+using namespace std;
+
+/*
+ * 批量导入历史消费（新商场上线 一次几百万行）三段流水线：
+ *   读取线程 --(文本块)--> 解析线程 × N --(解析好的行)--> 插入（调用线程 按文件顺序）
+ * - 读取：fread 大块读 在最后一个 '\n' 处切开 剩下半行留给下一块 块带顺序号
+ * - 解析：每块独立解析（零分配切字段 见 utility.h）坏行计数 + 记前几条的行号和原因
+ * - 插入：按顺序号重排后依次交给 insert(vector<ImportRow>&) 结果和逐行顺序导入一致
+ * - 两段之间都是 BoundedQueue（见 bounded_queue.h）插入跟不上时解析和读取会停下来等
+ * - 重排窗口：解析线程领到的块号 >= 已插入块数 + (线程数 + kQueueBlocks) 时先等插入追上来
+ *   否则一个慢的解析线程拖住 next 时 其余线程解析好的块会在重排缓冲里无限堆积
+ *   所以重排缓冲最多 (线程数 + kQueueBlocks) 块 在途的块一共不超过 (kQueueBlocks * 3 + 线程数 * 2) 内存和文件大小无关
+ *
+ * 行格式（每行一笔 '|' 或 ',' 分隔 有 '|' 就按 '|' 切）：
+ *   会员号 , 日期 , 商品 , 原价 [, 等级 [, 姓名 [, 电话]]]
+ * - 日期 YYYY-MM-DD 必填（历史数据 不默认今天）商品留空 = 未填写 等级 0/1/2 留空 = 0
+ * - 逗号分隔时字段可以用双引号括起来（"" 表示一个引号）字段里可以有逗号
+ * - 空行 / # 开头的行忽略 第一行不是数据（没有合法日期和金额）时当表头跳过
+ * - 等级 / 姓名 / 电话只在会员不存在、需要自动建档时用
+ */
+
+namespace bulk {
+
+    const size_t kReadBlock = 1 << 20;   // 每次 fread 的字节数（也是一块文本的大小）
+    const size_t kQueueBlocks = 4;       // 每个队列最多排几块
+    const size_t kRejectSamples = 10;    // 报告里保留几条被拒行的明细
+
+    struct ImportRow {
+        string memberId;
+        string date;
+        int    dateKey = 0;
+        string item;
+        Money  amount;
+        int    level = 0;
+        string name;
+        string phone;
+    };
+
+    struct ImportReport {
+        size_t lines = 0;            // 数据行（不含空行 / 注释 / 表头）
+        size_t imported = 0;
+        size_t rejected = 0;
+        size_t membersCreated = 0;
+        size_t bytes = 0;
+        double seconds = 0;
+        string error;                // 打不开 / 读文件出错
+        vector<pair<size_t, string>> samples;   // 前 kRejectSamples 条被拒的 (行号, 原因)
+
+        double rowsPerSecond() const { return seconds > 0 ? imported / seconds : 0; }
+    };
+
+    // 读取 -> 解析
+    struct TextBlock {
+        size_t seq = 0;
+        string text;
+    };
+
+    // 解析 -> 插入 行号是块内的（从 1 开始）插入时按顺序加上前面各块的行数
+    struct ParsedBlock {
+        size_t seq = 0;
+        size_t lineCount = 0;
+        size_t dataLines = 0;
+        vector<ImportRow> rows;
+        size_t rejected = 0;
+        vector<pair<size_t, string>> samples;
+    };
+
+    // 逗号分隔的下一个字段写到 out（去掉两侧空白 / 引号）pos 移到下一个字段开头
+    // 引号没闭合返回 false
+    inline bool nextCsvField(string_view line, size_t& pos, string& out) {
+        out.clear();
+        while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) ++pos;
+        if (pos < line.size() && line[pos] == '"') {
+            ++pos;
+            while (true) {
+                if (pos >= line.size()) return false;
+                if (line[pos] == '"') {
+                    if (pos + 1 < line.size() && line[pos + 1] == '"') { out += '"'; pos += 2; continue; }
+                    ++pos;
+                    break;
+                }
+                out += line[pos++];
+            }
+            while (pos < line.size() && line[pos] != ',') ++pos;   // 右引号之后到逗号之间的内容忽略
+        } else {
+            size_t comma = line.find(',', pos);
+            if (comma == string_view::npos) comma = line.size();
+            string_view f = util::trimView(line.substr(pos, comma - pos));
+            out.assign(f.data(), f.size());
+            pos = comma;
+        }
+        if (pos < line.size()) ++pos;   // 跳过逗号
+        else pos = line.size() + 1;     // 标记已经没有字段了
+        return true;
+    }
+
+    // 切成最多 7 个字段 返回字段数 引号没闭合返回 0
+    inline size_t splitImportFields(string_view line, string* f) {
+        if (line.find('|') != string_view::npos) {
+            string_view v[7];
+            size_t n = util::splitByPipeView(line, v, 7);
+            if (n > 7) n = 7;
+            for (size_t i = 0; i < n; ++i) f[i].assign(v[i].data(), v[i].size());
+            return n;
+        }
+        size_t n = 0, pos = 0;
+        while (n < 7 && pos <= line.size()) {
+            if (!nextCsvField(line, pos, f[n])) return 0;
+            ++n;
+        }
+        return n;
+    }
+
+    // 一行 -> ImportRow 失败返回原因
+    inline const char* parseImportRow(string_view line, ImportRow& row) {
+        string f[7];
+        size_t n = splitImportFields(line, f);
+        if (n == 0) return "引号没有闭合";
+        if (n < 4) return "字段不足";
+        if (f[0].empty()) return "会员号为空";
+        row.dateKey = util::dateToInt(f[1]);
+        if (row.dateKey == 0) return "日期格式不合法";
+        if (!Money::parse(f[3], row.amount) || row.amount < Money()) return "金额无效";
+        row.level = 0;
+        if (n >= 5 && !f[4].empty()) {
+            if (f[4].size() != 1 || f[4][0] < '0' || f[4][0] > '2') return "等级只能是 0/1/2";
+            row.level = f[4][0] - '0';
+        }
+        row.memberId = std::move(f[0]);
+        row.date = std::move(f[1]);
+        row.item = f[2].empty() ? string("未填写") : std::move(f[2]);
+        if (n >= 6) row.name = std::move(f[5]);
+        if (n >= 7) row.phone = std::move(f[6]);
+        return nullptr;
+    }
+
+    // 表头：第二列不是日期 第四列也不是金额
+    inline bool looksLikeHeader(string_view line) {
+        string f[7];
+        size_t n = splitImportFields(line, f);
+        Money m;
+        return n >= 4 && util::dateToInt(f[1]) == 0 && !Money::parse(f[3], m);
+    }
+
+    inline void parseBlock(const TextBlock& in, ParsedBlock& out) {
+        out.seq = in.seq;
+        const char* b = in.text.data();
+        loader::forEachLine(b, b + in.text.size(), [&](const char* lb, const char* le) {
+            const size_t lineNo = ++out.lineCount;
+            string_view line = util::trimView(string_view(lb, static_cast<size_t>(le - lb)));
+            if (line.empty() || line[0] == '#') return;
+            if (in.seq == 0 && lineNo == 1 && looksLikeHeader(line)) return;
+            ++out.dataLines;
+            ImportRow row;
+            const char* err = parseImportRow(line, row);
+            if (!err) {
+                out.rows.push_back(std::move(row));
+                return;
+            }
+            ++out.rejected;
+            if (out.samples.size() < kRejectSamples) out.samples.push_back(make_pair(lineNo, string(err)));
+        });
+    }
+
+    // 跑完整条流水线 insert(vector<ImportRow>& rows) 在调用线程里按文件顺序调用（每块一次）
+    // insert 返回本块实际插入的行数 被拒的行由调用方自己计入 report.rejected / samples
+    // 读文件出错返回 false（已经插入的行不回滚）
+    template <typename Insert>
+    bool run(FILE* in, unsigned workers, ImportReport& report, Insert insert) {
+        if (workers == 0) workers = 1;
+        const chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+
+        BoundedQueue<TextBlock> texts(kQueueBlocks);
+        BoundedQueue<ParsedBlock> parsed(kQueueBlocks);
+        bool readFailed = false;
+        size_t bytes = 0;
+
+        thread reader([&]() {
+            string carry;
+            size_t seq = 0;
+            vector<char> buf(kReadBlock);
+            while (true) {
+                size_t got = fread(buf.data(), 1, buf.size(), in);
+                if (got == 0) {
+                    readFailed = ferror(in) != 0;
+                    break;
+                }
+                bytes += got;
+                carry.append(buf.data(), got);
+                // 只交出完整的行 最后半行留到下一次
+                const char* nl = static_cast<const char*>(memrchr(carry.data(), '\n', carry.size()));
+                if (!nl) continue;
+                const size_t cut = static_cast<size_t>(nl - carry.data()) + 1;
+                TextBlock block;
+                block.seq = seq++;
+                block.text.assign(carry, cut, string::npos);
+                block.text.swap(carry);   // carry = 剩下的半行 block.text = 完整的行
+                block.text.resize(cut);
+                if (!texts.push(std::move(block))) return;
+            }
+            if (!carry.empty()) {
+                TextBlock block;
+                block.seq = seq++;
+                block.text.swap(carry);
+                texts.push(std::move(block));
+            }
+            texts.close();
+        });
+
+        // 重排窗口 块号是按顺序领的 next 那一块一定在某个解析线程手里或已经解析完 等待不会死锁
+        const size_t window = workers + kQueueBlocks;
+        mutex windowMutex;
+        condition_variable windowMoved;
+        size_t inserted = 0;   // 已插入的块数（windowMutex 保护）
+
+        atomic<unsigned> running(workers);
+        vector<thread> parsers;
+        for (unsigned w = 0; w < workers; ++w) {
+            parsers.emplace_back([&]() {
+                TextBlock block;
+                while (texts.pop(block)) {
+                    {
+                        unique_lock<mutex> lock(windowMutex);
+                        windowMoved.wait(lock, [&]() { return block.seq < inserted + window; });
+                    }
+                    ParsedBlock out;
+                    parseBlock(block, out);
+                    if (!parsed.push(std::move(out))) break;
+                }
+                if (running.fetch_sub(1) == 1) parsed.close();   // 最后一个退出的解析线程关下游
+            });
+        }
+
+        // 插入：乱序到达的块先放着 等前面的块（最多 window 块 见上）
+        map<size_t, ParsedBlock> pending;
+        size_t next = 0;
+        size_t lineBase = 0;
+        ParsedBlock block;
+        while (parsed.pop(block)) {
+            const size_t seq = block.seq;
+            pending.emplace(seq, std::move(block));
+            for (auto it = pending.find(next); it != pending.end(); it = pending.find(next)) {
+                ParsedBlock& p = it->second;
+                report.lines += p.dataLines;
+                report.rejected += p.rejected;
+                for (size_t i = 0; i < p.samples.size() && report.samples.size() < kRejectSamples; ++i) {
+                    report.samples.push_back(make_pair(lineBase + p.samples[i].first, p.samples[i].second));
+                }
+                if (!p.rows.empty()) report.imported += insert(p.rows);
+                lineBase += p.lineCount;
+                pending.erase(it);
+                ++next;
+                {
+                    lock_guard<mutex> lock(windowMutex);
+                    inserted = next;
+                }
+                windowMoved.notify_all();
+            }
+        }
+
+        reader.join();
+        for (size_t i = 0; i < parsers.size(); ++i) parsers[i].join();
+
+        report.bytes = bytes;
+        report.seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        if (readFailed) report.error = "读文件出错";
+        return !readFailed;
+    }
+
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <array>
+#include <cstdio>
+#include <unistd.h>
+
+#include "durable_file.h"
+#include "parallel_loader.h"
+#include "utility.h"
+
+using namespace std;
+
+/*
+ * checkpoint 提交记录：一次 checkpoint 要换掉好几个快照文件（members.txt / 交易快照 / 归档清单）
+ * 单个 rename 是原子的 几个 rename 之间崩溃就会留下新旧混搭的快照 所以先写一份提交记录 它落盘 = 整次 checkpoint 生效
+ *   G | 代数                        每次 checkpoint +1
+ *   N | 下一个交易号                  提交时的水位线（快照里最大的交易号可能属于已删除的会员 不能从快照反推）
+ *   R | 临时文件 | 目标文件          已生效 但还没做完的 rename
+ * - commit：各临时文件 fsync -> 写提交记录（临时文件 + fsync + rename + 目录 fsync）
+ * - finish：逐个 rename -> 目录 fsync -> 去掉 R 行；启动时 / 下次 checkpoint 开始前都先 finish 一次
+ *   临时文件已经不在 = 上次已经 rename 过了 跳过
+ * - 日志第一行也记代数（见 journal.h 的 C 记录）日志代数比这里旧 = 日志里的改动都已经在快照里 重放时跳过
+ *   （commit 之后、日志截断之前崩溃的情况）
+ * 本身不加锁 由调用方（checkpoint 时持有日志锁）保护
+ */
+
+class CheckpointManifest {
+private:
+    string                      mPath;
+    long                        mGeneration = 0;
+    long                        mNextTransactionId = 0;   // 0 = 没记（旧版本写的提交记录）
+    vector<pair<string, string>> mPending;   // 已生效没做完的 (临时文件, 目标文件)
+    vector<pair<string, string>> mStaged;    // 本次 checkpoint 写好的临时文件
+
+    bool write(long generation, long nextTransactionId, const vector<pair<string, string>>& renames) const {
+        const string tmp = mPath + ".tmp";
+        {
+            ofstream fout(tmp.c_str());
+            if (!fout) return false;
+            fout << "G | " << generation << "\n";
+            if (nextTransactionId > 0) fout << "N | " << nextTransactionId << "\n";
+            for (size_t i = 0; i < renames.size(); ++i) {
+                fout << "R | " << renames[i].first << " | " << renames[i].second << "\n";
+            }
+            if (!fout.flush()) return false;
+        }
+        return durable::replaceFile(tmp, mPath);
+    }
+
+public:
+    explicit CheckpointManifest(const string& path) : mPath(path) {}
+
+    long generation() const { return mGeneration; }
+    long nextTransactionId() const { return mNextTransactionId; }
+
+    // 启动时读代数和没做完的 rename（文件不存在 = 还没 checkpoint 过 代数 0）
+    void load() {
+        mGeneration = 0;
+        mNextTransactionId = 0;
+        mPending.clear();
+        mStaged.clear();
+        string data;
+        if (!loader::readWholeFile(mPath, data)) return;
+        loader::forEachLine(data.data(), data.data() + data.size(), [&](const char* b, const char* e) {
+            string_view line = util::trimView(string_view(b, static_cast<size_t>(e - b)));
+            if (line.size() < 4 || line[1] != ' ' || line[2] != '|') return;
+            string_view body = line.substr(4);
+            if (line[0] == 'G') {
+                mGeneration = util::parseLong(body);
+            } else if (line[0] == 'N') {
+                mNextTransactionId = util::parseLong(body);
+            } else if (line[0] == 'R') {
+                array<string_view, 2> f;
+                if (util::splitFields(body, f)) mPending.push_back(make_pair(string(f[0]), string(f[1])));
+            }
+        });
+    }
+
+    // 做完已生效的 rename 失败返回 false（R 行留着 下次再做）
+    bool finish() {
+        if (mPending.empty()) return true;
+        for (size_t i = 0; i < mPending.size(); ++i) {
+            if (access(mPending[i].first.c_str(), F_OK) != 0) continue;
+            if (rename(mPending[i].first.c_str(), mPending[i].second.c_str()) != 0) return false;
+        }
+        for (size_t i = 0; i < mPending.size(); ++i) {
+            if (!durable::syncDir(mPending[i].second)) return false;
+        }
+        if (!write(mGeneration, mNextTransactionId, vector<pair<string, string>>())) return false;
+        mPending.clear();
+        return true;
+    }
+
+    // tmpPath 已经写完（不用自己 fsync）commit 时替换 path
+    void add(const string& tmpPath, const string& path) { mStaged.push_back(make_pair(tmpPath, path)); }
+
+    // 本次 checkpoint 没写完 删掉已经写好的临时文件
+    void discard() {
+        for (size_t i = 0; i < mStaged.size(); ++i) remove(mStaged[i].first.c_str());
+        mStaged.clear();
+    }
+
+    // 提交点：返回 true 后新快照已经生效（代数 +1）接着要 finish 并把日志换成新代数
+    // 返回 false 时什么都没变（临时文件已删）旧快照 + 日志仍然完整
+    // nextTransactionId：当前的交易号水位线 启动时交易号从不低于它开始
+    bool commit(long nextTransactionId) {
+        for (size_t i = 0; i < mStaged.size(); ++i) {
+            if (!durable::syncFile(mStaged[i].first)) {
+                discard();
+                return false;
+            }
+        }
+        if (!write(mGeneration + 1, nextTransactionId, mStaged)) {
+            discard();
+            return false;
+        }
+        ++mGeneration;
+        mNextTransactionId = nextTransactionId;
+        mPending.swap(mStaged);
+        mStaged.clear();
+        return true;
+    }
+};
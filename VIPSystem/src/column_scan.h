@@ -0,0 +1,335 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <climits>
+#include <cstring>
+
+#include "simd_scan.h"
+
+/*
+ * 列扫描内核：在交易表的列（见 transaction_columns.h）上按日期区间过滤 / 求和 / 计数 / 最小最大
+ * - 每行都带一个标志字节（墓碑 / 已归档）flags & skipMask != 0 的行跳过
+ * - AVX2：一次 8 行（dateKey 是 int32）金额 int64 分两半累加
+ * - SSE2：一次 4 行；maxOf 要 64 位比较（SSE4.2）SSE2 级别退回标量
+ * - 标量：无分支写法 其它平台 / 尾巴
+ *
+ * 级别跟随 simd_scan.h 的运行时检测（forceLevel 会同时影响这里）每次调用只多一次分支
+ * 只用非对齐 load 且不越过 n 读 调用方不需要额外的缓冲区填充
+ */
+
+namespace simd {
+
+    // 过滤出来的行的合计 minKey / maxKey 在 count == 0 时无意义
+    struct RangeTotals {
+        size_t  count = 0;
+        int64_t amountCents = 0;
+        int64_t payCents = 0;
+        int64_t points = 0;
+        int     minKey = INT_MAX;
+        int     maxKey = INT_MIN;
+
+        void merge(const RangeTotals& o) {
+            count += o.count;
+            amountCents += o.amountCents;
+            payCents += o.payCents;
+            points += o.points;
+            if (o.minKey < minKey) minKey = o.minKey;
+            if (o.maxKey > maxKey) maxKey = o.maxKey;
+        }
+    };
+
+    namespace detail {
+
+        // ---------- 标量 ----------
+
+        inline size_t selectBetweenScalar(const int32_t* keys, const uint8_t* flags, uint8_t skipMask,
+                                          size_t begin, size_t n, int lo, int hi, uint32_t* out) {
+            size_t c = 0;
+            for (size_t i = begin; i < n; ++i) {
+                out[c] = static_cast<uint32_t>(i);
+                c += (keys[i] >= lo) & (keys[i] <= hi) & ((flags[i] & skipMask) == 0);
+            }
+            return c;
+        }
+
+        inline void sumBetweenScalar(const int32_t* keys, const uint8_t* flags, uint8_t skipMask,
+                                     const int64_t* amount, const int64_t* pay, const int32_t* points,
+                                     size_t begin, size_t n, int lo, int hi, RangeTotals& t) {
+            for (size_t i = begin; i < n; ++i) {
+                const int k = keys[i];
+                if (k < lo || k > hi || (flags[i] & skipMask)) continue;
+                ++t.count;
+                t.amountCents += amount[i];
+                t.payCents += pay[i];
+                t.points += points[i];
+                if (k < t.minKey) t.minKey = k;
+                if (k > t.maxKey) t.maxKey = k;
+            }
+        }
+
+        inline int64_t maxOfScalar(const int64_t* v, const uint8_t* flags, uint8_t skipMask,
+                                   size_t begin, size_t n, int64_t best) {
+            for (size_t i = begin; i < n; ++i) {
+                if (!(flags[i] & skipMask) && v[i] > best) best = v[i];
+            }
+            return best;
+        }
+
+#if defined(VIP_SIMD_X86)
+        // ---------- SSE2 ----------
+
+        // 4 个标志字节 -> 4 × int32 通过的行全 1
+        __attribute__((target("sse2")))
+        inline __m128i flagsPassSse2(const uint8_t* flags, uint8_t skipMask) {
+            int32_t raw;
+            memcpy(&raw, flags, 4);
+            const __m128i zero = _mm_setzero_si128();
+            __m128i f = _mm_and_si128(_mm_cvtsi32_si128(raw), _mm_set1_epi8(static_cast<char>(skipMask)));
+            f = _mm_unpacklo_epi16(_mm_unpacklo_epi8(f, zero), zero);
+            return _mm_cmpeq_epi32(f, zero);
+        }
+
+        // lo <= key <= hi 且标志通过 的 4 × int32 掩码
+        __attribute__((target("sse2")))
+        inline __m128i passMaskSse2(const int32_t* keys, const uint8_t* flags, uint8_t skipMask,
+                                    __m128i lo, __m128i hi) {
+            __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys));
+            __m128i out = _mm_or_si128(_mm_cmpgt_epi32(lo, k), _mm_cmpgt_epi32(k, hi));
+            return _mm_andnot_si128(out, flagsPassSse2(flags, skipMask));
+        }
+
+        __attribute__((target("sse2")))
+        inline size_t selectBetweenSse2(const int32_t* keys, const uint8_t* flags, uint8_t skipMask,
+                                        size_t n, int lo, int hi, uint32_t* out) {
+            const __m128i vlo = _mm_set1_epi32(lo), vhi = _mm_set1_epi32(hi);
+            size_t c = 0, i = 0;
+            for (; i + 4 <= n; i += 4) {
+                // 不按位循环（命中率 50% 左右时分支全猜错）每个位置都写 只按位推进
+                const unsigned m = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(
+                    passMaskSse2(keys + i, flags + i, skipMask, vlo, vhi))));
+                for (unsigned j = 0; j < 4; ++j) {
+                    out[c] = static_cast<uint32_t>(i + j);
+                    c += (m >> j) & 1;
+                }
+            }
+            return c + selectBetweenScalar(keys, flags, skipMask, i, n, lo, hi, out + c);
+        }
+
+        // int32 符号扩展成两组 int64
+        __attribute__((target("sse2")))
+        inline void widenSse2(__m128i x, __m128i& low, __m128i& high) {
+            const __m128i sign = _mm_srai_epi32(x, 31);
+            low = _mm_unpacklo_epi32(x, sign);
+            high = _mm_unpackhi_epi32(x, sign);
+        }
+
+        __attribute__((target("sse2")))
+        inline RangeTotals sumBetweenSse2(const int32_t* keys, const uint8_t* flags, uint8_t skipMask,
+                                          const int64_t* amount, const int64_t* pay, const int32_t* points,
+                                          size_t n, int lo, int hi) {
+            const __m128i vlo = _mm_set1_epi32(lo), vhi = _mm_set1_epi32(hi);
+            __m128i sumAmount = _mm_setzero_si128(), sumPay = _mm_setzero_si128(), sumPoints = _mm_setzero_si128();
+            __m128i vmin = _mm_set1_epi32(INT_MAX), vmax = _mm_set1_epi32(INT_MIN);
+            size_t count = 0, i = 0;
+            for (; i + 4 <= n; i += 4) {
+                const __m128i m = passMaskSse2(keys + i, flags + i, skipMask, vlo, vhi);
+                const int bits = _mm_movemask_ps(_mm_castsi128_ps(m));
+                if (bits == 0) continue;
+                count += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(bits)));
+
+                __m128i m0, m1;
+                widenSse2(m, m0, m1);
+                sumAmount = _mm_add_epi64(sumAmount, _mm_and_si128(m0, _mm_loadu_si128(reinterpret_cast<const __m128i*>(amount + i))));
+                sumAmount = _mm_add_epi64(sumAmount, _mm_and_si128(m1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(amount + i + 2))));
+                sumPay = _mm_add_epi64(sumPay, _mm_and_si128(m0, _mm_loadu_si128(reinterpret_cast<const __m128i*>(pay + i))));
+                sumPay = _mm_add_epi64(sumPay, _mm_and_si128(m1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(pay + i + 2))));
+                __m128i p0, p1;
+                widenSse2(_mm_and_si128(m, _mm_loadu_si128(reinterpret_cast<const __m128i*>(points + i))), p0, p1);
+                sumPoints = _mm_add_epi64(sumPoints, _mm_add_epi64(p0, p1));
+
+                // 没选中的行换成不影响结果的值 再取最小 / 最大（SSE2 没有 min_epi32 用比较 + 选择）
+                const __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+                const __m128i kmin = _mm_or_si128(_mm_and_si128(m, k), _mm_andnot_si128(m, _mm_set1_epi32(INT_MAX)));
+                const __m128i kmax = _mm_or_si128(_mm_and_si128(m, k), _mm_andnot_si128(m, _mm_set1_epi32(INT_MIN)));
+                const __m128i lt = _mm_cmpgt_epi32(vmin, kmin);
+                vmin = _mm_or_si128(_mm_and_si128(lt, kmin), _mm_andnot_si128(lt, vmin));
+                const __m128i gt = _mm_cmpgt_epi32(kmax, vmax);
+                vmax = _mm_or_si128(_mm_and_si128(gt, kmax), _mm_andnot_si128(gt, vmax));
+            }
+
+            RangeTotals t;
+            int64_t a[2], p[2], pts[2];
+            int32_t mn[4], mx[4];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(a), sumAmount);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p), sumPay);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pts), sumPoints);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(mn), vmin);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(mx), vmax);
+            t.count = count;
+            t.amountCents = a[0] + a[1];
+            t.payCents = p[0] + p[1];
+            t.points = pts[0] + pts[1];
+            for (int j = 0; j < 4; ++j) {
+                if (mn[j] < t.minKey) t.minKey = mn[j];
+                if (mx[j] > t.maxKey) t.maxKey = mx[j];
+            }
+            sumBetweenScalar(keys, flags, skipMask, amount, pay, points, i, n, lo, hi, t);
+            return t;
+        }
+
+        // ---------- AVX2 ----------
+
+        // 8 位掩码 -> 选中车道的下标挤到前面（permutevar8x32 的控制字）一共 8KB 第一次用时生成
+        inline const uint32_t* compressTable() {
+            static const struct Table {
+                uint32_t idx[256][8];
+                Table() {
+                    for (unsigned m = 0; m < 256; ++m) {
+                        unsigned c = 0;
+                        for (unsigned j = 0; j < 8; ++j) {
+                            if (m & (1u << j)) idx[m][c++] = j;
+                        }
+                        for (; c < 8; ++c) idx[m][c] = 0;
+                    }
+                }
+            } table;
+            return &table.idx[0][0];
+        }
+
+        __attribute__((target("avx2")))
+        inline __m256i passMaskAvx2(const int32_t* keys, const uint8_t* flags, uint8_t skipMask,
+                                    __m256i lo, __m256i hi) {
+            __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys));
+            __m256i out = _mm256_or_si256(_mm256_cmpgt_epi32(lo, k), _mm256_cmpgt_epi32(k, hi));
+            __m256i f = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(flags)));
+            f = _mm256_and_si256(f, _mm256_set1_epi32(skipMask));
+            return _mm256_andnot_si256(out, _mm256_cmpeq_epi32(f, _mm256_setzero_si256()));
+        }
+
+        __attribute__((target("avx2")))
+        inline size_t selectBetweenAvx2(const int32_t* keys, const uint8_t* flags, uint8_t skipMask,
+                                        size_t n, int lo, int hi, uint32_t* out) {
+            const __m256i vlo = _mm256_set1_epi32(lo), vhi = _mm256_set1_epi32(hi);
+            const uint32_t* table = compressTable();
+            __m256i pos = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            const __m256i step = _mm256_set1_epi32(8);
+            size_t c = 0, i = 0;
+            for (; i + 8 <= n; i += 8) {
+                // 选中的行号挤到前面整块写出 c <= i 所以写到 out[c + 7] 不会超过 out[n - 1]
+                const unsigned m = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(
+                    passMaskAvx2(keys + i, flags + i, skipMask, vlo, vhi))));
+                const __m256i ctl = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(table + m * 8));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + c), _mm256_permutevar8x32_epi32(pos, ctl));
+                c += static_cast<size_t>(__builtin_popcount(m));
+                pos = _mm256_add_epi32(pos, step);
+            }
+            return c + selectBetweenScalar(keys, flags, skipMask, i, n, lo, hi, out + c);
+        }
+
+        __attribute__((target("avx2")))
+        inline RangeTotals sumBetweenAvx2(const int32_t* keys, const uint8_t* flags, uint8_t skipMask,
+                                          const int64_t* amount, const int64_t* pay, const int32_t* points,
+                                          size_t n, int lo, int hi) {
+            const __m256i vlo = _mm256_set1_epi32(lo), vhi = _mm256_set1_epi32(hi);
+            __m256i sumAmount = _mm256_setzero_si256(), sumPay = _mm256_setzero_si256(), sumPoints = _mm256_setzero_si256();
+            __m256i vmin = _mm256_set1_epi32(INT_MAX), vmax = _mm256_set1_epi32(INT_MIN);
+            size_t count = 0, i = 0;
+            for (; i + 8 <= n; i += 8) {
+                const __m256i m = passMaskAvx2(keys + i, flags + i, skipMask, vlo, vhi);
+                const int bits = _mm256_movemask_ps(_mm256_castsi256_ps(m));
+                if (bits == 0) continue;
+                count += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(bits)));
+
+                const __m256i m0 = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(m));
+                const __m256i m1 = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(m, 1));
+                sumAmount = _mm256_add_epi64(sumAmount, _mm256_and_si256(m0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(amount + i))));
+                sumAmount = _mm256_add_epi64(sumAmount, _mm256_and_si256(m1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(amount + i + 4))));
+                sumPay = _mm256_add_epi64(sumPay, _mm256_and_si256(m0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pay + i))));
+                sumPay = _mm256_add_epi64(sumPay, _mm256_and_si256(m1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pay + i + 4))));
+                const __m256i pts = _mm256_and_si256(m, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(points + i)));
+                sumPoints = _mm256_add_epi64(sumPoints, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(pts)));
+                sumPoints = _mm256_add_epi64(sumPoints, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(pts, 1)));
+
+                const __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+                vmin = _mm256_min_epi32(vmin, _mm256_blendv_epi8(_mm256_set1_epi32(INT_MAX), k, m));
+                vmax = _mm256_max_epi32(vmax, _mm256_blendv_epi8(_mm256_set1_epi32(INT_MIN), k, m));
+            }
+
+            RangeTotals t;
+            int64_t a[4], p[4], pts[4];
+            int32_t mn[8], mx[8];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(a), sumAmount);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), sumPay);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(pts), sumPoints);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(mn), vmin);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(mx), vmax);
+            t.count = count;
+            t.amountCents = a[0] + a[1] + a[2] + a[3];
+            t.payCents = p[0] + p[1] + p[2] + p[3];
+            t.points = pts[0] + pts[1] + pts[2] + pts[3];
+            for (int j = 0; j < 8; ++j) {
+                if (mn[j] < t.minKey) t.minKey = mn[j];
+                if (mx[j] > t.maxKey) t.maxKey = mx[j];
+            }
+            sumBetweenScalar(keys, flags, skipMask, amount, pay, points, i, n, lo, hi, t);
+            return t;
+        }
+
+        __attribute__((target("avx2")))
+        inline int64_t maxOfAvx2(const int64_t* v, const uint8_t* flags, uint8_t skipMask, size_t n, int64_t best) {
+            __m256i vmax = _mm256_set1_epi64x(best);
+            const __m256i skip = _mm256_set1_epi64x(skipMask);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                int32_t raw;
+                memcpy(&raw, flags + i, 4);
+                __m256i f = _mm256_and_si256(_mm256_cvtepu8_epi64(_mm_cvtsi32_si128(raw)), skip);
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i));
+                // 跳过的行当成 best（不会改变最大值）
+                x = _mm256_blendv_epi8(x, vmax, _mm256_cmpgt_epi64(f, _mm256_setzero_si256()));
+                vmax = _mm256_blendv_epi8(vmax, x, _mm256_cmpgt_epi64(x, vmax));
+            }
+            int64_t lanes[4];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), vmax);
+            for (int j = 0; j < 4; ++j) {
+                if (lanes[j] > best) best = lanes[j];
+            }
+            return maxOfScalar(v, flags, skipMask, i, n, best);
+        }
+#endif
+    }
+
+    // [lo, hi] 内且 flags & skipMask == 0 的行号写到 out（至少 n 个位置）返回条数 行号升序
+    inline size_t selectBetween(const int32_t* keys, const uint8_t* flags, uint8_t skipMask, size_t n,
+                                int lo, int hi, uint32_t* out) {
+#if defined(VIP_SIMD_X86)
+        const Level level = activeLevel();
+        if (level == kAvx2) return detail::selectBetweenAvx2(keys, flags, skipMask, n, lo, hi, out);
+        if (level == kSse2) return detail::selectBetweenSse2(keys, flags, skipMask, n, lo, hi, out);
+#endif
+        return detail::selectBetweenScalar(keys, flags, skipMask, 0, n, lo, hi, out);
+    }
+
+    // [lo, hi] 内且 flags & skipMask == 0 的行：笔数 / 原价 / 实付 / 积分合计 + 最小 / 最大 dateKey
+    inline RangeTotals sumBetween(const int32_t* keys, const uint8_t* flags, uint8_t skipMask,
+                                  const int64_t* amount, const int64_t* pay, const int32_t* points,
+                                  size_t n, int lo, int hi) {
+#if defined(VIP_SIMD_X86)
+        const Level level = activeLevel();
+        if (level == kAvx2) return detail::sumBetweenAvx2(keys, flags, skipMask, amount, pay, points, n, lo, hi);
+        if (level == kSse2) return detail::sumBetweenSse2(keys, flags, skipMask, amount, pay, points, n, lo, hi);
+#endif
+        RangeTotals t;
+        detail::sumBetweenScalar(keys, flags, skipMask, amount, pay, points, 0, n, lo, hi, t);
+        return t;
+    }
+
+    // flags & skipMask == 0 的行里的最大值 没有这样的行返回 init
+    inline int64_t maxOf(const int64_t* v, const uint8_t* flags, uint8_t skipMask, size_t n, int64_t init) {
+#if defined(VIP_SIMD_X86)
+        if (activeLevel() == kAvx2) return detail::maxOfAvx2(v, flags, skipMask, n, init);
+#endif
+        return detail::maxOfScalar(v, flags, skipMask, 0, n, init);
+    }
+
+}
@@ -0,0 +1,155 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <array>
+
+#include "money.h"
+#include "utility.h"
+
+using namespace std;
+
+/*
+ * 批处理 / 服务端 共用的文本命令
+ * 一行一条 字段用 | 分隔（和 members.txt / transactions.txt 一样）
+ *
+ * ADD   | id | name | phone | level      新增会员（level 0/1/2 省略为 0）
+ * EDIT  | id | name | phone              修改会员（字段留空表示不改）
+ * DEL   | id                             删除会员（含交易记录）
+ * BUY   | id | date | item | amount      记录消费（date 留空=今天 item 留空=未填写）
+ * QUERY | id                             查询会员（一行汇总）
+ * RANK  | id                             会员积分名次
+ * TOP   | points | k                     积分前 k 名（k 省略为 10）
+ * TOP   | spend | k | from | to          区间实付前 k 名（from 留空=不限日期 to 留空=今天）
+ * REPORT | day/month/level | from | to  营收汇总（from 留空=不限日期 to 留空=今天）
+ * SEAL  | date                           把早于 date 的交易封存为归档段文件（随后自动 checkpoint）
+ * CHECKPOINT                             立即保存快照并清空日志
+ * STATS                                  运行统计（一行 见 stats.h）
+ *
+ * 空行和 # 开头的行忽略
+ * 每条命令回应一行：OK ... 或 ERR 原因
+ */
+
+struct Command {
+    enum Type { kNone, kAdd, kEdit, kDelete, kBuy, kQuery, kRank, kTop, kReport, kSeal, kCheckpoint, kStats };
+
+    Type   type = kNone;
+    string id;
+    string name;
+    string phone;
+    int    level = 0;
+    string date;
+    string toDate;  // TOP spend / REPORT 的区间终点
+    string item;
+    Money  amount;
+    size_t limit = 10;
+};
+
+// 返回 false 时 err 是错误原因；空行/注释返回 true 且 type == kNone
+inline bool parseCommand(string_view line, Command& cmd, string& err) {
+    cmd = Command();
+    line = util::trimView(line);
+    if (line.empty() || line[0] == '#') return true;
+
+    array<string_view, 5> f;
+    size_t n = util::splitByPipeView(line, f.data(), f.size());
+    string_view op = f[0];
+
+    auto need = [&](size_t count) {
+        if (n >= count) return true;
+        err = "字段不足";
+        return false;
+    };
+
+    if (op == "ADD") {
+        if (!need(4)) return false;
+        cmd.type = Command::kAdd;
+        cmd.name = string(f[2]);
+        cmd.phone = string(f[3]);
+        cmd.level = (n >= 5) ? util::parseInt(f[4]) : 0;
+        if (cmd.level < 0 || cmd.level > 2) cmd.level = 0;
+    } else if (op == "EDIT") {
+        if (!need(4)) return false;
+        cmd.type = Command::kEdit;
+        cmd.name = string(f[2]);
+        cmd.phone = string(f[3]);
+    } else if (op == "DEL") {
+        if (!need(2)) return false;
+        cmd.type = Command::kDelete;
+    } else if (op == "BUY") {
+        if (!need(5)) return false;
+        cmd.type = Command::kBuy;
+        cmd.date = string(f[2]);
+        cmd.item = string(f[3]);
+        if (!Money::parse(f[4], cmd.amount) || cmd.amount < Money()) {
+            err = "金额无效";
+            return false;
+        }
+    } else if (op == "QUERY") {
+        if (!need(2)) return false;
+        cmd.type = Command::kQuery;
+    } else if (op == "RANK") {
+        if (!need(2)) return false;
+        cmd.type = Command::kRank;
+    } else if (op == "TOP") {
+        if (!need(2)) return false;
+        cmd.type = Command::kTop;
+        if (f[1] != "points" && f[1] != "spend") {
+            err = "排行类型只能是 points 或 spend";
+            return false;
+        }
+        if (n >= 3 && !f[2].empty()) {
+            int k = util::parseInt(f[2]);
+            if (k <= 0) {
+                err = "名次数无效";
+                return false;
+            }
+            cmd.limit = static_cast<size_t>(k);
+        }
+        if (n >= 4 && !f[3].empty()) {
+            cmd.date = string(f[3]);
+            cmd.toDate = (n >= 5 && !f[4].empty()) ? string(f[4]) : util::todayDate();
+            if (util::dateToInt(cmd.date) == 0 || util::dateToInt(cmd.toDate) == 0) {
+                err = "日期格式不合法";
+                return false;
+            }
+        }
+    } else if (op == "REPORT") {
+        if (!need(2)) return false;
+        cmd.type = Command::kReport;
+        if (f[1] != "day" && f[1] != "month" && f[1] != "level") {
+            err = "汇总粒度只能是 day / month / level";
+            return false;
+        }
+        if (n >= 3 && !f[2].empty()) {
+            cmd.date = string(f[2]);
+            cmd.toDate = (n >= 4 && !f[3].empty()) ? string(f[3]) : util::todayDate();
+            if (util::dateToInt(cmd.date) == 0 || util::dateToInt(cmd.toDate) == 0) {
+                err = "日期格式不合法";
+                return false;
+            }
+        }
+    } else if (op == "SEAL") {
+        if (!need(2)) return false;
+        cmd.type = Command::kSeal;
+        if (util::dateToInt(f[1]) == 0) {
+            err = "日期格式不合法";
+            return false;
+        }
+    } else if (op == "CHECKPOINT") {
+        cmd.type = Command::kCheckpoint;
+        return true;
+    } else if (op == "STATS") {
+        cmd.type = Command::kStats;
+        return true;
+    } else {
+        err = "未知命令";
+        return false;
+    }
+
+    cmd.id = string(f[1]);
+    if (cmd.id.empty()) {
+        err = "会员号不能为空";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*
+ * 落盘小工具：写完的文件要 fsync 内容才在盘上；rename / 新建之后还要 fsync 所在目录 目录项才在盘上
+ * 只 fsync 文件不 fsync 目录：掉电后可能看到的还是旧文件（或者新文件名根本不存在）
+ */
+
+namespace durable {
+
+    // fsync 一个已经写完（已关闭）的文件 Linux 上只读打开也能 fsync
+    inline bool syncFile(const string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        const bool ok = ::fsync(fd) == 0;
+        ::close(fd);
+        return ok;
+    }
+
+    inline string dirOf(const string& path) {
+        size_t slash = path.rfind('/');
+        if (slash == string::npos) return ".";
+        return slash == 0 ? string("/") : path.substr(0, slash);
+    }
+
+    // fsync path 所在的目录
+    inline bool syncDir(const string& path) {
+        int fd = ::open(dirOf(path).c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd < 0) return false;
+        const bool ok = ::fsync(fd) == 0;
+        ::close(fd);
+        return ok;
+    }
+
+    // 临时文件 fsync -> rename -> 目录 fsync 返回 true 时新内容已经在盘上
+    inline bool replaceFile(const string& tmpPath, const string& path) {
+        if (!syncFile(tmpPath)) return false;
+        if (rename(tmpPath.c_str(), path.c_str()) != 0) return false;
+        return syncDir(path);
+    }
+
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include "money.h"
 
 /*
  * 仿函数（Functor）
@@ -7,10 +8,10 @@
 namespace functor {
 
     struct PointsCalculator {
-        int operator()(double pay) const {
-            if (pay <= 0) return 0;
-            // static_cast<int> 向下取整 68.0->6
-            return static_cast<int>(pay / 10.0);
+        int operator()(Money pay) const {
+            if (pay.cents() <= 0) return 0;
+            // 整数除法向下取整 68.00 元 = 6800 分 -> 6
+            return static_cast<int>(pay.cents() / 1000);
         }
     };
 
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+
+/*
+ * HDR 风格的延迟直方图（对数-线性分桶 单位纳秒）
+ * - 每个 2 的幂区间再等分 kSubBuckets 份：相对误差 < 1/16（约 6%）
+ * - < 16ns 的值精确记录 >= 2^40ns（约 18 分钟）的值并入最后一档
+ * - 固定 kBuckets 个计数 记录一次就是一次数组加一 合并就是逐桶相加
+ * 分位数报告的是所在桶的上界（偏保守 不会把尾延迟说小）
+ */
+
+class LatencyHistogram {
+public:
+    static const unsigned kSubBits = 4;
+    static const unsigned kSubBuckets = 1u << kSubBits;
+    static const unsigned kMaxBits = 40;
+    static const unsigned kBuckets = (kMaxBits - kSubBits + 2) * kSubBuckets;
+
+    static unsigned bucketOf(uint64_t v) {
+        if (v < kSubBuckets) return static_cast<unsigned>(v);
+        unsigned msb = 63u - static_cast<unsigned>(__builtin_clzll(v));
+        if (msb >= kMaxBits) return kBuckets - 1;
+        unsigned shift = msb - kSubBits;
+        return (shift + 1) * kSubBuckets + static_cast<unsigned>((v >> shift) & (kSubBuckets - 1));
+    }
+
+    // 桶内最大值
+    static uint64_t upperBoundOf(unsigned b) {
+        if (b < kSubBuckets) return b;
+        unsigned shift = b / kSubBuckets - 1;
+        uint64_t low = static_cast<uint64_t>(kSubBuckets + b % kSubBuckets) << shift;
+        return low + (1ULL << shift) - 1;
+    }
+
+private:
+    uint64_t mCounts[kBuckets];
+    uint64_t mTotal = 0;
+    uint64_t mSum = 0;
+    uint64_t mMax = 0;
+
+public:
+    LatencyHistogram() { memset(mCounts, 0, sizeof(mCounts)); }
+
+    void record(uint64_t ns) {
+        ++mCounts[bucketOf(ns)];
+        ++mTotal;
+        mSum += ns;
+        if (ns > mMax) mMax = ns;
+    }
+
+    // 直接按桶累加（合并每线程的计数用）
+    void addBucket(unsigned b, uint64_t n) { mCounts[b] += n; mTotal += n; }
+    void addSum(uint64_t sum, uint64_t maxNs) { mSum += sum; if (maxNs > mMax) mMax = maxNs; }
+
+    void merge(const LatencyHistogram& o) {
+        for (unsigned b = 0; b < kBuckets; ++b) mCounts[b] += o.mCounts[b];
+        mTotal += o.mTotal;
+        mSum += o.mSum;
+        if (o.mMax > mMax) mMax = o.mMax;
+    }
+
+    void clear() {
+        memset(mCounts, 0, sizeof(mCounts));
+        mTotal = mSum = mMax = 0;
+    }
+
+    uint64_t count() const { return mTotal; }
+    uint64_t max() const { return mMax; }
+    uint64_t mean() const { return mTotal ? mSum / mTotal : 0; }
+
+    // q in [0, 1]
+    uint64_t percentile(double q) const {
+        if (mTotal == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(mTotal) + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > mTotal) rank = mTotal;
+        uint64_t seen = 0;
+        for (unsigned b = 0; b < kBuckets; ++b) {
+            seen += mCounts[b];
+            if (seen >= rank) {
+                uint64_t v = upperBoundOf(b);
+                return v < mMax ? v : mMax;
+            }
+        }
+        return mMax;
+    }
+};
@@ -0,0 +1,172 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "stats.h"
+
+using namespace std;
+
+/*
+ * 预写日志（WAL / journal）
+ * - 新增/修改/删除会员、记录消费：每次只追加一行 写入量只和本次改动有关
+ * - 组提交：记录先攒在内存缓冲区 满 mGroupSize 条或调用 sync() 时一次 write + 一次 fsync
+ *   sync() 返回 false = 没有落盘 调用方不能回 OK（见 VipService::syncJournal）
+ * - 启动：先读快照（members.txt / transactions.txt）再按顺序重放日志
+ * - checkpoint：saveAll 写完快照后 truncate 清空日志 第一行写上新快照的代数（见 checkpoint.h）
+ *
+ * 记录格式（一行一条 字段仍用 | 分隔 和快照文件一致）：
+ * C | generation                                                            日志对应的快照代数（第一行）
+ * A | id | name | phone | level | points | joinDate                          新增会员
+ * E | id | name | phone                                                     修改会员
+ * D | id                                                                    删除会员
+ * P | transactionId | memberId | date | item | amount | pay | pointsEarned  记录消费
+ */
+
+class Journal {
+private:
+    string mPath;
+    int    mFd = -1;
+    string mBuffer;          // 还没 write 的记录
+    size_t mPending = 0;     // 缓冲区里的记录条数
+    size_t mGroupSize;
+    bool   mFailed = false;  // fsync 失败过 见 sync()
+    long   mGeneration = 0;  // 新日志第一行写的快照代数
+
+private:
+    Journal(const Journal&);
+    Journal& operator=(const Journal&);
+
+    bool writeHeader() {
+        const string header = "C | " + to_string(mGeneration) + "\n";
+        ssize_t n;
+        do {
+            n = ::write(mFd, header.data(), header.size());
+        } while (n < 0 && errno == EINTR);
+        return n == static_cast<ssize_t>(header.size()) && ::fsync(mFd) == 0;
+    }
+
+    // 文件里最后一个 '\n' 之后的位置（没有完整记录时是 0）读失败返回 -1
+    static off_t completeLength(int fd, off_t size) {
+        char buf[512];
+        off_t end = size;
+        while (end > 0) {
+            const size_t n = end < static_cast<off_t>(sizeof(buf)) ? static_cast<size_t>(end) : sizeof(buf);
+            if (::pread(fd, buf, n, end - static_cast<off_t>(n)) != static_cast<ssize_t>(n)) return -1;
+            const char* nl = static_cast<const char*>(memrchr(buf, '\n', n));
+            if (nl) return end - static_cast<off_t>(n) + (nl - buf) + 1;
+            end -= static_cast<off_t>(n);
+        }
+        return 0;
+    }
+
+public:
+    explicit Journal(const string& path, size_t groupSize = 64)
+        : mPath(path), mGroupSize(groupSize == 0 ? 1 : groupSize) {}
+
+    ~Journal() {
+        sync();
+        if (mFd >= 0) ::close(mFd);
+    }
+
+    const string& path() const { return mPath; }
+
+    bool open() {
+        if (mFd >= 0) return true;
+        // O_APPEND 保证每次 write 都落在文件尾
+        mFd = ::open(mPath.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (mFd < 0) return false;
+        // 崩溃留下的半行（readRecords 已经丢弃）要从文件里截掉 否则下一条记录会接在它后面 两条一起坏
+        const off_t size = ::lseek(mFd, 0, SEEK_END);
+        const off_t keep = completeLength(mFd, size);
+        if (keep >= 0 && keep < size && ::ftruncate(mFd, keep) == 0) ::fsync(mFd);
+        if (keep == 0 && !writeHeader()) mFailed = true;
+        return true;
+    }
+
+    // open 之前设置（启动时取 CheckpointManifest 的代数）
+    void setGeneration(long generation) { mGeneration = generation; }
+
+    void setGroupSize(size_t n) { mGroupSize = (n == 0 ? 1 : n); }
+
+    // tag 见文件头的记录格式 body 是 | 分隔的字段
+    void append(char tag, const string& body) {
+        mBuffer += tag;
+        mBuffer += " | ";
+        mBuffer += body;
+        mBuffer += '\n';
+        if (++mPending >= mGroupSize) sync();
+    }
+
+    // 一次 write 整个缓冲区 再 fsync 一次（组提交）缓冲区里的记录都落盘才返回 true
+    // - write 出错：已经写出去的前缀从缓冲区删掉（不能再写一遍）剩下的下次 sync 再试
+    // - fsync 出错：页缓存里的数据可能已经丢了 再 fsync 也可能“成功” 所以之后一直返回 false
+    //   直到 truncate（checkpoint 把全部状态重新写进了快照）
+    bool sync() {
+        if (mFailed) {
+            mBuffer.clear();   // 写不进去了 等 checkpoint 把状态写进快照
+            mPending = 0;
+            return false;
+        }
+        if (mPending == 0) return true;
+        if (!open()) return false;
+
+        size_t done = 0;
+        while (done < mBuffer.size()) {
+            ssize_t n = ::write(mFd, mBuffer.data() + done, mBuffer.size() - done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                mBuffer.erase(0, done);
+                return false;
+            }
+            done += static_cast<size_t>(n);
+        }
+        VIP_STATS_ADD(stats::kBytesWritten, mBuffer.size());
+        mBuffer.clear();
+        mPending = 0;
+        if (::fsync(mFd) != 0) {
+            mFailed = true;
+            return false;
+        }
+        return true;
+    }
+
+    // checkpoint 之后调用：快照里已经包含了日志里的所有改动 日志从新代数重新开始
+    // 失败时日志和快照的代数对不上 之后的 sync 一直返回 false（重启会把旧代数的日志整个跳过）
+    bool truncate(long generation) {
+        mBuffer.clear();
+        mPending = 0;
+        mGeneration = generation;
+        mFailed = true;
+        if (!open()) return false;
+        if (::ftruncate(mFd, 0) != 0 || !writeHeader()) return false;
+        mFailed = false;
+        return true;
+    }
+
+    // 读出所有完整记录
+    // 崩溃时最后一行可能只写了一半（没有 '\n'）直接丢弃
+    static vector<string> readRecords(const string& path) {
+        vector<string> records;
+        ifstream fin(path.c_str(), ios::binary);
+        if (!fin) return records;
+
+        ostringstream oss;
+        oss << fin.rdbuf();
+        const string data = oss.str();
+
+        size_t begin = 0;
+        while (true) {
+            size_t nl = data.find('\n', begin);
+            if (nl == string::npos) break;
+            if (nl > begin) records.push_back(data.substr(begin, nl - begin));
+            begin = nl + 1;
+        }
+        return records;
+    }
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <mutex>
+#include <cstdint>
+
+#include "histogram.h"
+
+using namespace std;
+
+/*
+ * 延迟记录：全程累计的 LatencyHistogram（见 histogram.h）+ 一把锁
+ * - record 批量写入（提交线程每批一次加锁）
+ * - snapshot 取分位数 内存固定 不随样本数增长
+ */
+
+struct LatencySummary {
+    uint64_t count = 0;
+    uint64_t p50Ns = 0;
+    uint64_t p99Ns = 0;
+    uint64_t p999Ns = 0;
+    uint64_t maxNs = 0;
+};
+
+class LatencyRecorder {
+private:
+    mutable mutex    mMutex;
+    LatencyHistogram mHistogram;
+
+public:
+    void record(const uint64_t* ns, size_t n) {
+        lock_guard<mutex> lock(mMutex);
+        for (size_t i = 0; i < n; ++i) mHistogram.record(ns[i]);
+    }
+
+    LatencySummary snapshot() const {
+        lock_guard<mutex> lock(mMutex);
+        LatencySummary out;
+        out.count = mHistogram.count();
+        out.p50Ns = mHistogram.percentile(0.50);
+        out.p99Ns = mHistogram.percentile(0.99);
+        out.p999Ns = mHistogram.percentile(0.999);
+        out.maxNs = mHistogram.max();
+        return out;
+    }
+};
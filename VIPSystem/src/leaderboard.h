@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+
+using namespace std;
+
+/*
+ * 积分排行榜：带子树大小的红黑树（GNU pb_ds 顺序统计树）
+ * - 键是 (-积分, 会员号)：树的中序就是积分从高到低 同分按会员号
+ * - 积分变化 = 删旧键 + 插新键 O(log n)
+ * - 前 K 名：从头走 K 步 O(log n + K) 不再全表排序
+ * - 名次：比他积分高的人数 + 1（同分同名次）order_of_key O(log n)
+ * 本身不加锁 也不记每个人的积分：调用方持有会员分片锁 旧积分 / 新积分由调用方给
+ */
+
+class PointsLeaderboard {
+private:
+    typedef pair<int, string> Key;
+    typedef __gnu_pbds::tree<Key, __gnu_pbds::null_type, less<Key>, __gnu_pbds::rb_tree_tag,
+                             __gnu_pbds::tree_order_statistics_node_update> Tree;
+
+    Tree mTree;
+
+public:
+    size_t size() const { return mTree.size(); }
+    void clear() { mTree.clear(); }
+
+    void insert(const string& id, int points) { mTree.insert(Key(-points, id)); }
+    void erase(const string& id, int points) { mTree.erase(Key(-points, id)); }
+
+    void update(const string& id, int oldPoints, int newPoints) {
+        if (oldPoints == newPoints) return;
+        erase(id, oldPoints);
+        insert(id, newPoints);
+    }
+
+    // 1 起 积分为 points 的会员的名次
+    size_t rankOf(int points) const { return mTree.order_of_key(Key(-points, string())) + 1; }
+
+    // 前 k 名 (会员号, 积分)
+    vector<pair<string, int>> top(size_t k) const {
+        vector<pair<string, int>> out;
+        out.reserve(k < mTree.size() ? k : mTree.size());
+        for (Tree::const_iterator it = mTree.begin(); it != mTree.end() && out.size() < k; ++it) {
+            out.push_back(make_pair(it->second, -it->first));
+        }
+        return out;
+    }
+};
@@ -1,7 +1,88 @@
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
 #include "vip_system.h"
+#include "vip_server.h"
+
+/*
+ * proc                                   交互菜单
+ * proc --batch <file|-> [--checkpoint N]  批处理（- 表示 stdin）
+ * proc --serve <unix:/path|tcp:PORT>      服务端（Ctrl+C 保存并退出）
+ * proc --convert                         交易快照（文本 + 归档段 + 日志）转换成二进制快照 transactions.txt.bin
+ *                                        之后启动只映射该文件（见 mapped_store.h）已经是二进制快照时合并增量文件
+ * proc --import <file|-> [--threads N]   批量导入历史消费（见 bulk_import.h）导入完 checkpoint
+ *
+ * 以上都可以再加 --stats-dump <file> <秒>：定时把运行统计追加到 file
+ */
+int main(int argc, char** argv) {
+    VipSystem system("members.txt", "transactions.txt", "journal.log");
+
+    // 先摘掉 --stats-dump 剩下的参数按原来的位置解析
+    for (int i = 1; i + 2 < argc; ++i) {
+        if (strcmp(argv[i], "--stats-dump") != 0) continue;
+        system.startStatsDump(argv[i + 1], static_cast<unsigned>(atoi(argv[i + 2])));
+        for (int j = i; j + 3 <= argc; ++j) argv[j] = argv[j + 3];
+        argc -= 3;
+        break;
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "--batch") == 0) {
+        size_t checkpointEvery = 0;
+        if (argc >= 5 && strcmp(argv[3], "--checkpoint") == 0) checkpointEvery = strtoul(argv[4], nullptr, 10);
+
+        ios::sync_with_stdio(false);
+        if (strcmp(argv[2], "-") == 0) {
+            system.runBatch(cin, cout, checkpointEvery);
+        } else {
+            ifstream fin(argv[2]);
+            if (!fin) { cerr << "无法打开 " << argv[2] << "\n"; return 1; }
+            system.runBatch(fin, cout, checkpointEvery);
+        }
+        return 0;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "--convert") == 0) {
+        VipService& service = system.service();
+        if (!service.loadAll()) return 1;
+        size_t bytes = 0;
+        if (!service.convertToBinary(&bytes)) {
+            cerr << "写二进制快照 " << service.binaryFilePath() << " 失败\n";
+            return 1;
+        }
+        cerr << "已转换 " << service.transactionCount() << " 笔交易 -> " << service.binaryFilePath()
+             << "（" << bytes << " 字节）transactions.txt 和归档段之后不再读写\n";
+        return 0;
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "--import") == 0) {
+        unsigned threads = 0;
+        if (argc >= 5 && strcmp(argv[3], "--threads") == 0) threads = static_cast<unsigned>(atoi(argv[4]));
+
+        VipService& service = system.service();
+        if (!service.loadAll()) return 1;
+        bool ok = system.importFile(argv[2], threads, cerr);
+        if (!service.saveAll()) {
+            cerr << "保存快照失败（已导入的行仍在日志里）\n";
+            ok = false;
+        }
+        return ok ? 0 : 1;
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "--serve") == 0) {
+        VipService& service = system.service();
+        if (!service.loadAll()) return 1;
+        VipServer server(service);
+        if (!server.listen(argv[2])) return 1;
+        cerr << "正在监听 " << argv[2] << "\n";
+        server.run();
+        if (!service.saveAll()) {
+            cerr << "保存快照失败（改动仍在日志里）共处理 " << server.requests() << " 条命令\n";
+            return 1;
+        }
+        cerr << "已保存，退出 共处理 " << server.requests() << " 条命令\n";
+        return 0;
+    }
 
-int main() {
-    VipSystem system("members.txt", "transactions.txt");
     system.run();
     return 0;
 }
@@ -0,0 +1,558 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <utility>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "transaction.h"
+#include "string_dict.h"
+#include "member_aggregate.h"
+#include "rollup.h"
+#include "segment.h"
+#include "utility.h"
+
+using namespace std;
+
+/*
+ * 二进制交易快照（mmap 只读）：定长记录 + 字符串堆 + 事先建好的索引 启动时只校验文件头
+ *
+ * 布局（本机字节序 各段 8 字节对齐 偏移 / 长度都记在文件头里）：
+ *   文件头        魔数 "VIPBIN01" / 版本 / 行数 / 下一个交易号 / 文件字节数 / 各段偏移和长度 / 头部校验和
+ *   记录          行数 × Record（48 字节定长 金额是分）
+ *   日期目录      (天数 + 1) × DayEntry  dateKey 升序 第 i 天的行 = 日期下标[start_i, start_i+1)
+ *   日期下标      行数 × uint32          按日期分组 组内按行号
+ *   会员起点      (会员数 + 1) × uint32  第 m 个会员的行 = 会员下标[start_m, start_m+1)
+ *   会员下标      行数 × uint32
+ *   会员汇总      会员数 × MemberSummary
+ *   会员哈希表    2 的幂个 uint32 槽 FNV-1a(会员号) 线性探测 存 会员编号 + 1（0 = 空）
+ *   字符串偏移    会员号 / 商品 / 日期例外 各 (条数 + 1) × uint64 指向字符串堆
+ *   字符串堆
+ *   日营收汇总    RollupEntry × 条数（dateKey + 等级 一条）
+ *
+ * - 打开 = mmap + 校验文件头 和行数无关；记录不逐条校验（文件只由 write 生成 先写临时文件 fsync 再 rename）
+ *   取字符串 / 遍历下标时做边界检查 文件内容损坏最多查出错的数据 不会越界读
+ * - 查询直接读映射里的记录 不反序列化成 vector<Transaction> 页面由内核按需换入
+ * - date 字符串不是 dateKey 标准写法的行（空 / 非法日期）原文放进日期例外 其余行不存日期字符串
+ */
+
+namespace mapped {
+
+    const char kMagic[8] = { 'V', 'I', 'P', 'B', 'I', 'N', '0', '1' };
+    const uint32_t kVersion = 1;
+    const uint32_t kNone = 0xFFFFFFFFu;
+
+    enum Section {
+        kRecords, kDays, kDatePositions, kMemberStarts, kMemberPositions, kMemberSummaries,
+        kMemberHash, kMemberOffsets, kItemOffsets, kDateTextOffsets, kHeap, kRollup,
+        kSectionCount
+    };
+
+    struct FileHeader {
+        char     magic[8];
+        uint32_t version;
+        uint32_t headerBytes;
+        uint64_t rows;
+        int64_t  nextTransactionId;
+        uint64_t fileBytes;
+        uint32_t members;
+        uint32_t items;
+        uint32_t dateTexts;
+        uint32_t days;
+        uint32_t hashSlots;
+        uint32_t rollupEntries;
+        uint64_t offset[kSectionCount];
+        uint64_t length[kSectionCount];
+        uint64_t checksum;       // FNV-1a 覆盖前面的全部字段
+    };
+
+    struct Record {
+        int64_t  transactionId;
+        int64_t  amountCents;
+        int64_t  payCents;
+        int32_t  dateKey;
+        uint32_t member;         // 会员编号（文件内）
+        uint32_t item;           // 商品编号（文件内）
+        int32_t  points;
+        uint32_t dateText;       // 日期例外编号 kNone = 标准写法
+        uint32_t reserved;
+    };
+
+    struct DayEntry {
+        int32_t  dateKey;
+        uint32_t start;
+    };
+
+    struct MemberSummary {
+        int64_t count;
+        int64_t amountCents;
+        int64_t payCents;
+        int64_t points;
+        int32_t firstDateKey;
+        int32_t lastDateKey;
+    };
+
+    struct RollupEntry {
+        int32_t dateKey;
+        int32_t level;
+        int64_t count;
+        int64_t amountCents;
+        int64_t payCents;
+        int64_t points;
+    };
+
+    static_assert(sizeof(Record) == 48, "Record 必须是 48 字节");
+    static_assert(sizeof(MemberSummary) == 40, "MemberSummary 必须是 40 字节");
+    static_assert(sizeof(RollupEntry) == 40, "RollupEntry 必须是 40 字节");
+
+    inline uint64_t align8(uint64_t n) { return (n + 7) & ~static_cast<uint64_t>(7); }
+
+    inline uint64_t headerChecksum(const FileHeader& h) {
+        return segment::fnv1a(reinterpret_cast<const char*>(&h), offsetof(FileHeader, checksum));
+    }
+
+    // 逐行 add 最后 write 一次性生成整个文件（write 只能调用一次）
+    class Writer {
+    private:
+        vector<Record>          mRecords;
+        StringDict              mMembers;
+        StringDict              mItems;
+        StringDict              mDateTexts;
+        vector<MemberAggregate> mSummaries;     // 会员编号下标
+        vector<int>             mLevels;        // 会员编号下标
+        map<int, uint32_t>      mDayRows;       // dateKey -> 行数
+        map<int, RollupBucket>  mRollup;        // 日桶
+        int                     mCachedKey = -1;
+        string                  mCachedDate;
+
+        bool canonicalDate(const Transaction& t) {
+            if (t.dateKey != mCachedKey) { mCachedKey = t.dateKey; mCachedDate = util::intToDate(t.dateKey); }
+            return t.date == mCachedDate;
+        }
+
+    public:
+        size_t size() const { return mRecords.size(); }
+
+        // levelOf(memberId) -> 等级 每个会员只问一次（营收汇总按等级分）
+        template <typename LevelOf>
+        void add(const Transaction& t, string_view memberId, string_view item, LevelOf levelOf) {
+            Record r;
+            memset(&r, 0, sizeof(r));
+            r.transactionId = t.transactionId;
+            r.amountCents = t.amount.cents();
+            r.payCents = t.pay.cents();
+            r.dateKey = t.dateKey;
+            r.points = t.pointsEarned;
+
+            const size_t members = mMembers.size();
+            r.member = mMembers.intern(memberId);
+            if (r.member == members) {
+                int lv = levelOf(memberId);
+                mLevels.push_back((lv < 0 || lv >= RollupBucket::kLevels) ? 0 : lv);
+                mSummaries.push_back(MemberAggregate());
+            }
+            r.item = mItems.intern(item);
+            r.dateText = canonicalDate(t) ? kNone : mDateTexts.intern(t.date);
+
+            mSummaries[r.member].add(t);
+            ++mDayRows[t.dateKey];
+            mRollup[t.dateKey].level[mLevels[r.member]].add(t);
+            mRecords.push_back(r);
+        }
+
+        // 写到 path 并 fsync（path 是临时文件 由调用方 rename 到位 见 checkpoint.h）返回文件字节数 失败返回 0
+        // checksum 不为空时带回文件头校验和（增量文件用它认底层）
+        size_t write(const string& path, long nextTransactionId, uint64_t* checksum = nullptr) {
+            const uint64_t rows = mRecords.size();
+            if (rows > 0xFFFFFFFFull) return 0;
+
+            // 日期目录 + 日期下标（计数排序 组内保持行号顺序）
+            vector<DayEntry> days;
+            days.reserve(mDayRows.size() + 1);
+            uint32_t start = 0;
+            for (auto it = mDayRows.begin(); it != mDayRows.end(); ++it) {
+                DayEntry d = { it->first, start };
+                days.push_back(d);
+                const uint32_t n = it->second;
+                it->second = start;   // 之后当填充游标用
+                start += n;
+            }
+            DayEntry sentinel = { 0, start };
+            days.push_back(sentinel);
+            vector<uint32_t> datePositions(rows);
+            for (uint32_t i = 0; i < rows; ++i) datePositions[mDayRows[mRecords[i].dateKey]++] = i;
+
+            // 会员起点 + 会员下标 + 汇总
+            const uint32_t members = static_cast<uint32_t>(mMembers.size());
+            vector<uint32_t> memberStarts(members + 1, 0);
+            for (uint32_t m = 0; m < members; ++m) {
+                memberStarts[m + 1] = memberStarts[m] + static_cast<uint32_t>(mSummaries[m].count);
+            }
+            vector<uint32_t> cursor(memberStarts.begin(), memberStarts.end() - 1);
+            vector<uint32_t> memberPositions(rows);
+            for (uint32_t i = 0; i < rows; ++i) memberPositions[cursor[mRecords[i].member]++] = i;
+
+            vector<MemberSummary> summaries(members);
+            for (uint32_t m = 0; m < members; ++m) {
+                const MemberAggregate& a = mSummaries[m];
+                MemberSummary& s = summaries[m];
+                memset(&s, 0, sizeof(s));
+                s.count = static_cast<int64_t>(a.count);
+                s.amountCents = a.amount.cents();
+                s.payCents = a.pay.cents();
+                s.points = a.points;
+                s.firstDateKey = a.firstDateKey;
+                s.lastDateKey = a.lastDateKey;
+            }
+
+            // 会员号哈希表：槽数 >= 2 × 会员数 探测链短
+            uint32_t slots = 8;
+            while (slots < 2ull * members) slots <<= 1;
+            vector<uint32_t> hashTable(slots, 0);
+            for (uint32_t m = 0; m < members; ++m) {
+                const string& id = mMembers.str(m);
+                uint32_t s = static_cast<uint32_t>(segment::fnv1a(id.data(), id.size())) & (slots - 1);
+                while (hashTable[s] != 0) s = (s + 1) & (slots - 1);
+                hashTable[s] = m + 1;
+            }
+
+            // 字符串堆
+            string heap;
+            auto offsetsOf = [&](const StringDict& dict) {
+                vector<uint64_t> offsets(dict.size() + 1);
+                for (uint32_t i = 0; i < dict.size(); ++i) {
+                    offsets[i] = heap.size();
+                    heap += dict.str(i);
+                }
+                offsets[dict.size()] = heap.size();
+                return offsets;
+            };
+            vector<uint64_t> memberOffsets = offsetsOf(mMembers);
+            vector<uint64_t> itemOffsets = offsetsOf(mItems);
+            vector<uint64_t> dateTextOffsets = offsetsOf(mDateTexts);
+
+            vector<RollupEntry> rollup;
+            for (auto it = mRollup.begin(); it != mRollup.end(); ++it) {
+                for (int lv = 0; lv < RollupBucket::kLevels; ++lv) {
+                    const RollupCell& c = it->second.level[lv];
+                    if (c.count == 0) continue;
+                    RollupEntry e;
+                    memset(&e, 0, sizeof(e));
+                    e.dateKey = it->first;
+                    e.level = lv;
+                    e.count = static_cast<int64_t>(c.count);
+                    e.amountCents = c.amount.cents();
+                    e.payCents = c.pay.cents();
+                    e.points = c.points;
+                    rollup.push_back(e);
+                }
+            }
+
+            FileHeader h;
+            memset(&h, 0, sizeof(h));
+            memcpy(h.magic, kMagic, sizeof(kMagic));
+            h.version = kVersion;
+            h.headerBytes = sizeof(FileHeader);
+            h.rows = rows;
+            h.nextTransactionId = nextTransactionId;
+            h.members = members;
+            h.items = static_cast<uint32_t>(mItems.size());
+            h.dateTexts = static_cast<uint32_t>(mDateTexts.size());
+            h.days = static_cast<uint32_t>(days.size() - 1);
+            h.hashSlots = slots;
+            h.rollupEntries = static_cast<uint32_t>(rollup.size());
+
+            const void* data[kSectionCount] = {
+                mRecords.data(), days.data(), datePositions.data(), memberStarts.data(), memberPositions.data(),
+                summaries.data(), hashTable.data(), memberOffsets.data(), itemOffsets.data(),
+                dateTextOffsets.data(), heap.data(), rollup.data()
+            };
+            h.length[kRecords] = rows * sizeof(Record);
+            h.length[kDays] = days.size() * sizeof(DayEntry);
+            h.length[kDatePositions] = rows * sizeof(uint32_t);
+            h.length[kMemberStarts] = memberStarts.size() * sizeof(uint32_t);
+            h.length[kMemberPositions] = rows * sizeof(uint32_t);
+            h.length[kMemberSummaries] = summaries.size() * sizeof(MemberSummary);
+            h.length[kMemberHash] = hashTable.size() * sizeof(uint32_t);
+            h.length[kMemberOffsets] = memberOffsets.size() * sizeof(uint64_t);
+            h.length[kItemOffsets] = itemOffsets.size() * sizeof(uint64_t);
+            h.length[kDateTextOffsets] = dateTextOffsets.size() * sizeof(uint64_t);
+            h.length[kHeap] = heap.size();
+            h.length[kRollup] = rollup.size() * sizeof(RollupEntry);
+
+            uint64_t pos = align8(sizeof(FileHeader));
+            for (int s = 0; s < kSectionCount; ++s) {
+                h.offset[s] = pos;
+                pos += align8(h.length[s]);
+            }
+            h.fileBytes = pos;
+            h.checksum = headerChecksum(h);
+
+            FILE* f = fopen(path.c_str(), "wb");
+            if (!f) return 0;
+            static const char zeros[8] = { 0 };
+            bool ok = fwrite(&h, 1, sizeof(h), f) == sizeof(h);
+            ok = ok && fwrite(zeros, 1, align8(sizeof(h)) - sizeof(h), f) == align8(sizeof(h)) - sizeof(h);
+            for (int s = 0; s < kSectionCount && ok; ++s) {
+                const size_t n = static_cast<size_t>(h.length[s]);
+                const size_t pad = static_cast<size_t>(align8(n) - n);
+                if (n > 0) ok = fwrite(data[s], 1, n, f) == n;
+                if (ok && pad > 0) ok = fwrite(zeros, 1, pad, f) == pad;
+            }
+            ok = (fflush(f) == 0) && ok;
+            ok = (fsync(fileno(f)) == 0) && ok;
+            fclose(f);
+            if (!ok) {
+                remove(path.c_str());
+                return 0;
+            }
+            if (checksum) *checksum = h.checksum;
+            return static_cast<size_t>(h.fileBytes);
+        }
+    };
+}
+
+// 只读映射 打开后到 close / 析构之前 返回的 Record 引用和 string_view 都有效
+class MappedTransactions {
+private:
+    const char*                  mData = nullptr;
+    size_t                       mBytes = 0;
+    const mapped::FileHeader*    mHeader = nullptr;
+    const mapped::Record*        mRecords = nullptr;
+    const mapped::DayEntry*      mDays = nullptr;
+    const uint32_t*              mDatePositions = nullptr;
+    const uint32_t*              mMemberStarts = nullptr;
+    const uint32_t*              mMemberPositions = nullptr;
+    const mapped::MemberSummary* mSummaries = nullptr;
+    const uint32_t*              mMemberHash = nullptr;
+    const uint64_t*              mMemberOffsets = nullptr;
+    const uint64_t*              mItemOffsets = nullptr;
+    const uint64_t*              mDateTextOffsets = nullptr;
+    const char*                  mHeap = nullptr;
+    const mapped::RollupEntry*   mRollup = nullptr;
+
+    MappedTransactions(const MappedTransactions&);
+    MappedTransactions& operator=(const MappedTransactions&);
+
+    template <typename T>
+    const T* section(mapped::Section s) const {
+        return reinterpret_cast<const T*>(mData + mHeader->offset[s]);
+    }
+
+    string_view stringAt(const uint64_t* offsets, uint32_t count, uint32_t i) const {
+        if (i >= count) return string_view();
+        const uint64_t b = offsets[i], e = offsets[i + 1];
+        if (b > e || e > mHeader->length[mapped::kHeap]) return string_view();
+        return string_view(mHeap + b, static_cast<size_t>(e - b));
+    }
+
+    // [begin, end) 范围内的下标 越界的跳过
+    template <typename Fn>
+    void forEachPosition(const uint32_t* positions, uint32_t begin, uint32_t end, Fn fn) const {
+        const uint64_t rows = mHeader->rows;
+        if (end > rows) end = static_cast<uint32_t>(rows);
+        for (uint32_t i = begin; i < end; ++i) {
+            if (positions[i] < rows) fn(static_cast<size_t>(positions[i]));
+        }
+    }
+
+    static bool fail(string* err, const string& msg) {
+        if (err) *err = msg;
+        return false;
+    }
+
+    bool validate(string* err) const {
+        using namespace mapped;
+        if (mBytes < sizeof(FileHeader)) return fail(err, "文件太短");
+        const FileHeader& h = *mHeader;
+        if (memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) return fail(err, "魔数不对");
+        if (h.version != kVersion || h.headerBytes != sizeof(FileHeader)) return fail(err, "版本不支持");
+        if (h.checksum != headerChecksum(h)) return fail(err, "文件头校验和不对");
+        if (h.fileBytes != mBytes) return fail(err, "文件大小和文件头不一致（可能被截断）");
+        if (h.rows > mBytes / sizeof(Record)) return fail(err, "行数超出文件大小");
+        if (h.hashSlots == 0 || (h.hashSlots & (h.hashSlots - 1)) != 0) return fail(err, "哈希表大小不对");
+
+        const uint64_t expected[kSectionCount] = {
+            h.rows * sizeof(Record),
+            (static_cast<uint64_t>(h.days) + 1) * sizeof(DayEntry),
+            h.rows * sizeof(uint32_t),
+            (static_cast<uint64_t>(h.members) + 1) * sizeof(uint32_t),
+            h.rows * sizeof(uint32_t),
+            static_cast<uint64_t>(h.members) * sizeof(MemberSummary),
+            static_cast<uint64_t>(h.hashSlots) * sizeof(uint32_t),
+            (static_cast<uint64_t>(h.members) + 1) * sizeof(uint64_t),
+            (static_cast<uint64_t>(h.items) + 1) * sizeof(uint64_t),
+            (static_cast<uint64_t>(h.dateTexts) + 1) * sizeof(uint64_t),
+            h.length[kHeap],
+            static_cast<uint64_t>(h.rollupEntries) * sizeof(RollupEntry)
+        };
+        for (int s = 0; s < kSectionCount; ++s) {
+            if (h.length[s] != expected[s]) return fail(err, "段长度和文件头不一致");
+            if (h.offset[s] % 8 != 0 || h.offset[s] < sizeof(FileHeader)) return fail(err, "段偏移不对");
+            if (h.length[s] > mBytes || h.offset[s] > mBytes - h.length[s]) return fail(err, "段超出文件范围");
+        }
+        return true;
+    }
+
+public:
+    MappedTransactions() {}
+    ~MappedTransactions() { close(); }
+
+    // mmap + 校验文件头 失败时 err 说明原因
+    bool open(const string& path, string* err = nullptr) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return fail(err, strerror(errno));
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return fail(err, "文件为空");
+        }
+        void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);   // 映射建立后不再需要描述符
+        if (p == MAP_FAILED) return fail(err, strerror(errno));
+
+        mData = static_cast<const char*>(p);
+        mBytes = static_cast<size_t>(st.st_size);
+        mHeader = reinterpret_cast<const mapped::FileHeader*>(mData);
+        if (!validate(err)) {
+            close();
+            return false;
+        }
+        mRecords = section<mapped::Record>(mapped::kRecords);
+        mDays = section<mapped::DayEntry>(mapped::kDays);
+        mDatePositions = section<uint32_t>(mapped::kDatePositions);
+        mMemberStarts = section<uint32_t>(mapped::kMemberStarts);
+        mMemberPositions = section<uint32_t>(mapped::kMemberPositions);
+        mSummaries = section<mapped::MemberSummary>(mapped::kMemberSummaries);
+        mMemberHash = section<uint32_t>(mapped::kMemberHash);
+        mMemberOffsets = section<uint64_t>(mapped::kMemberOffsets);
+        mItemOffsets = section<uint64_t>(mapped::kItemOffsets);
+        mDateTextOffsets = section<uint64_t>(mapped::kDateTextOffsets);
+        mHeap = section<char>(mapped::kHeap);
+        mRollup = section<mapped::RollupEntry>(mapped::kRollup);
+        return true;
+    }
+
+    void close() {
+        if (mData) munmap(const_cast<char*>(mData), mBytes);
+        mData = nullptr;
+        mBytes = 0;
+        mHeader = nullptr;
+    }
+
+    void swap(MappedTransactions& o) {
+        std::swap(mData, o.mData);
+        std::swap(mBytes, o.mBytes);
+        std::swap(mHeader, o.mHeader);
+        std::swap(mRecords, o.mRecords);
+        std::swap(mDays, o.mDays);
+        std::swap(mDatePositions, o.mDatePositions);
+        std::swap(mMemberStarts, o.mMemberStarts);
+        std::swap(mMemberPositions, o.mMemberPositions);
+        std::swap(mSummaries, o.mSummaries);
+        std::swap(mMemberHash, o.mMemberHash);
+        std::swap(mMemberOffsets, o.mMemberOffsets);
+        std::swap(mItemOffsets, o.mItemOffsets);
+        std::swap(mDateTextOffsets, o.mDateTextOffsets);
+        std::swap(mHeap, o.mHeap);
+        std::swap(mRollup, o.mRollup);
+    }
+
+    bool isOpen() const { return mHeader != nullptr; }
+    size_t bytes() const { return mBytes; }
+    size_t size() const { return mHeader ? static_cast<size_t>(mHeader->rows) : 0; }
+    long nextTransactionId() const { return mHeader ? static_cast<long>(mHeader->nextTransactionId) : 1; }
+    uint64_t checksum() const { return mHeader ? mHeader->checksum : 0; }
+    uint32_t memberCount() const { return mHeader ? mHeader->members : 0; }
+    uint32_t itemCount() const { return mHeader ? mHeader->items : 0; }
+
+    const mapped::Record& record(size_t pos) const { return mRecords[pos]; }
+
+    string_view memberId(uint32_t m) const { return mHeader ? stringAt(mMemberOffsets, mHeader->members, m) : string_view(); }
+    string_view item(uint32_t i) const { return mHeader ? stringAt(mItemOffsets, mHeader->items, i) : string_view(); }
+    string_view dateText(uint32_t d) const { return mHeader ? stringAt(mDateTextOffsets, mHeader->dateTexts, d) : string_view(); }
+
+    // 会员号 -> 文件内会员编号 不存在返回 mapped::kNone
+    uint32_t findMember(string_view id) const {
+        if (!mHeader) return mapped::kNone;
+        const uint32_t mask = mHeader->hashSlots - 1;
+        uint32_t s = static_cast<uint32_t>(segment::fnv1a(id.data(), id.size())) & mask;
+        for (uint32_t probes = 0; probes <= mask; ++probes, s = (s + 1) & mask) {
+            const uint32_t v = mMemberHash[s];
+            if (v == 0) return mapped::kNone;
+            if (memberId(v - 1) == id) return v - 1;
+        }
+        return mapped::kNone;
+    }
+
+    MemberAggregate summary(uint32_t m) const {
+        MemberAggregate a;
+        if (m >= memberCount()) return a;
+        const mapped::MemberSummary& s = mSummaries[m];
+        a.count = static_cast<size_t>(s.count);
+        a.amount = Money::fromCents(s.amountCents);
+        a.pay = Money::fromCents(s.payCents);
+        a.points = s.points;
+        a.firstDateKey = s.firstDateKey;
+        a.lastDateKey = s.lastDateKey;
+        return a;
+    }
+
+    // fn(size_t pos) 该会员的行 按行号
+    template <typename Fn>
+    void forEachMemberRow(uint32_t m, Fn fn) const {
+        if (m >= memberCount()) return;
+        forEachPosition(mMemberPositions, mMemberStarts[m], mMemberStarts[m + 1], fn);
+    }
+
+    // 日期目录：dayCount 天 按 dateKey 升序
+    size_t dayCount() const { return mHeader ? mHeader->days : 0; }
+    int dayKey(size_t day) const { return mDays[day].dateKey; }
+
+    // 第一个 dateKey >= key 的天
+    size_t dayLowerBound(int key) const {
+        size_t lo = 0, hi = dayCount();
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (mDays[mid].dateKey < key) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    template <typename Fn>
+    void forEachRowOfDay(size_t day, Fn fn) const {
+        forEachPosition(mDatePositions, mDays[day].start, mDays[day + 1].start, fn);
+    }
+
+    // [fromKey, toKey] 按日期升序回调 fn(size_t pos)
+    template <typename Fn>
+    void forEachBetween(int fromKey, int toKey, Fn fn) const {
+        for (size_t d = dayLowerBound(fromKey); d < dayCount() && mDays[d].dateKey <= toKey; ++d) forEachRowOfDay(d, fn);
+    }
+
+    // fn(int dateKey, int level, const RollupCell&)
+    template <typename Fn>
+    void forEachRollupCell(Fn fn) const {
+        const uint32_t n = mHeader ? mHeader->rollupEntries : 0;
+        for (uint32_t i = 0; i < n; ++i) {
+            const mapped::RollupEntry& e = mRollup[i];
+            RollupCell c;
+            c.count = static_cast<size_t>(e.count);
+            c.amount = Money::fromCents(e.amountCents);
+            c.pay = Money::fromCents(e.payCents);
+            c.points = e.points;
+            fn(e.dateKey, e.level, c);
+        }
+    }
+};
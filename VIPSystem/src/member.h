@@ -2,6 +2,7 @@
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <new>
 
 using namespace std;
 
@@ -33,7 +34,8 @@ public:
     // 多态接口 不同等级返回不同折扣/名称
     // 只拿Member指针 运行时自动分配到子类
     // 多态： 基类纯虚函数 派生类重写 调用基类指针or引用
-    virtual double discountRate() const = 0;
+    // 折扣用整数百分比 金额计算全程是整数（见 Money::applyPercent）
+    virtual int    discountPercent() const = 0;
     virtual string levelName() const = 0;
     virtual int    levelCode() const = 0;
 
@@ -66,7 +68,7 @@ class RegularMember : public Member {
 public:
     // C++11 继承基类的有参构造函数
     using Member::Member;
-    double discountRate() const override { return 1.0; }
+    int discountPercent() const override { return 100; }
     string levelName() const override { return "普通"; }
     int levelCode() const override { return 0; }
 };
@@ -74,7 +76,7 @@ public:
 class VipMember : public Member {
 public:
     using Member::Member;
-    double discountRate() const override { return 0.95; }
+    int discountPercent() const override { return 95; }
     string levelName() const override { return "VIP"; }
     int levelCode() const override { return 1; }
 };
@@ -82,22 +84,36 @@ public:
 class SvipMember : public Member {
 public:
     using Member::Member;
-    double discountRate() const override { return 0.85; }
+    int discountPercent() const override { return 85; }
     string levelName() const override { return "SVIP"; }
     int levelCode() const override { return 2; }
 };
 
+// 只有等级编号时的名称（报表按等级分组用）和各子类 levelName() 一致
+inline const char* levelNameOf(int levelCode) {
+    if (levelCode == 1) return "VIP";
+    if (levelCode == 2) return "SVIP";
+    return "普通";
+}
+
 /*
- * 从文件读 levelCode 后创建对应对象
- * 返回 new 出来的指针 由 VipSystem 统一 delete（避免内存泄漏）
+ * 按 levelCode（文件 / 日志 / 导入行里的等级）创建对应子类对象
+ * 在调用方给的内存上原地构造（placement new）不单独 new
+ * place 至少要 kMemberObjectSize 字节 由 MemberTable 的 arena 提供 析构也由它负责
  */
-inline Member* createMemberByLevel(int levelCode,
+const size_t kMemberObjectSize =
+    sizeof(RegularMember) > sizeof(VipMember)
+        ? (sizeof(RegularMember) > sizeof(SvipMember) ? sizeof(RegularMember) : sizeof(SvipMember))
+        : (sizeof(VipMember) > sizeof(SvipMember) ? sizeof(VipMember) : sizeof(SvipMember));
+
+inline Member* createMemberByLevel(void* place,
+                                  int levelCode,
                                   const string& id,
                                   const string& name,
                                   const string& phone,
                                   int points,
                                   const string& joinDate) {
-    if (levelCode == 1) return new VipMember(id, name, phone, points, joinDate);
-    if (levelCode == 2) return new SvipMember(id, name, phone, points, joinDate);
-    return new RegularMember(id, name, phone, points, joinDate);
+    if (levelCode == 1) return new (place) VipMember(id, name, phone, points, joinDate);
+    if (levelCode == 2) return new (place) SvipMember(id, name, phone, points, joinDate);
+    return new (place) RegularMember(id, name, phone, points, joinDate);
 }
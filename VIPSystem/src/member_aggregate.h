@@ -0,0 +1,78 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "transaction.h"
+#include "transaction_columns.h"
+#include "money.h"
+
+using namespace std;
+
+/*
+ * 每个会员的消费汇总（按会员编号 memberHandle 下标 O(1) 取）
+ * - 追加交易时顺手累加 不再每次查询都扫一遍该会员的全部交易
+ * - 删除会员：该会员的汇总清零
+ * - 加载完成 / 交易表压缩后 和两个索引一起 rebuild
+ * 首次 / 最近消费按日期（dateKey 最小 / 最大）不按录入顺序
+ */
+
+struct MemberAggregate {
+    size_t    count = 0;
+    Money     amount;          // 原价合计
+    Money     pay;             // 实付合计
+    long long points = 0;      // 消费获得的积分合计
+    int       firstDateKey = 0;
+    int       lastDateKey = 0;
+
+    void add(const Transaction& t) {
+        ++count;
+        amount += t.amount;
+        pay += t.pay;
+        points += t.pointsEarned;
+        if (firstDateKey == 0 || (t.dateKey != 0 && t.dateKey < firstDateKey)) firstDateKey = t.dateKey;
+        if (t.dateKey > lastDateKey) lastDateKey = t.dateKey;
+    }
+
+    // 同一会员两部分的汇总合在一起（二进制快照里的 + 内存里新增的）
+    void merge(const MemberAggregate& o) {
+        if (o.count == 0) return;
+        if (firstDateKey == 0 || (o.firstDateKey != 0 && o.firstDateKey < firstDateKey)) firstDateKey = o.firstDateKey;
+        if (o.lastDateKey > lastDateKey) lastDateKey = o.lastDateKey;
+        count += o.count;
+        amount += o.amount;
+        pay += o.pay;
+        points += o.points;
+    }
+};
+
+class MemberAggregates {
+private:
+    vector<MemberAggregate> mByHandle;
+
+public:
+    void clear() { mByHandle.clear(); }
+    size_t size() const { return mByHandle.size(); }
+
+    void add(const Transaction& t) {
+        if (t.memberHandle >= mByHandle.size()) mByHandle.resize(t.memberHandle + 1);
+        mByHandle[t.memberHandle].add(t);
+    }
+
+    void erase(uint32_t memberHandle) {
+        if (memberHandle < mByHandle.size()) mByHandle[memberHandle] = MemberAggregate();
+    }
+
+    void rebuild(const TransactionColumns& rows) {
+        mByHandle.clear();
+        Transaction t;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            rows.loadNumeric(i, t);
+            add(t);
+        }
+    }
+
+    // 没有消费过返回全零的汇总
+    MemberAggregate get(uint32_t memberHandle) const {
+        return memberHandle < mByHandle.size() ? mByHandle[memberHandle] : MemberAggregate();
+    }
+};
@@ -0,0 +1,203 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "member.h"
+
+using namespace std;
+
+/*
+ * 会员表：开放寻址哈希索引 + arena 连续存放会员对象
+ *
+ * MemberArena
+ * - 按块（kSlotsPerChunk 个槽）一次申请 每个槽放一个 Regular/Vip/Svip 对象
+ * - 删除的槽挂到空闲链表 下次新增直接复用
+ * - clear：逐个析构后 整块整块释放 不再一个个 delete
+ *
+ * MemberTable
+ * - 槽数组是 2 的幂 线性探测 槽里存 哈希值 + Member* 比较 id 之前先比哈希
+ * - 删除留墓碑（kTombstone）保证后面的探测链不断 墓碑太多时 rehash 清掉
+ * - Member* 指向 arena 里的对象 rehash 只搬槽 不搬对象 指针一直有效（直到被删除）
+ */
+
+class MemberArena {
+private:
+    static const size_t kAlign = alignof(max_align_t);
+    static const size_t kSlotSize = (kMemberObjectSize + kAlign - 1) / kAlign * kAlign;
+    static const size_t kSlotsPerChunk = 1024;
+
+    struct FreeNode { FreeNode* next; };
+
+    vector<unsigned char*> mChunks;
+    size_t    mUsedInLast = kSlotsPerChunk;  // 最后一块已经切出去的槽数
+    FreeNode* mFreeList = nullptr;
+
+private:
+    MemberArena(const MemberArena&);
+    MemberArena& operator=(const MemberArena&);
+
+public:
+    MemberArena() {}
+    ~MemberArena() { clear(); }
+
+    void* allocate() {
+        if (mFreeList) {
+            FreeNode* n = mFreeList;
+            mFreeList = n->next;
+            return n;
+        }
+        if (mUsedInLast == kSlotsPerChunk) {
+            mChunks.push_back(static_cast<unsigned char*>(::operator new(kSlotSize * kSlotsPerChunk)));
+            mUsedInLast = 0;
+        }
+        return mChunks.back() + kSlotSize * mUsedInLast++;
+    }
+
+    // p 上的对象必须已经析构
+    void release(void* p) {
+        FreeNode* n = static_cast<FreeNode*>(p);
+        n->next = mFreeList;
+        mFreeList = n;
+    }
+
+    // 整体释放（对象由调用方先析构）
+    void clear() {
+        for (size_t i = 0; i < mChunks.size(); ++i) ::operator delete(mChunks[i]);
+        mChunks.clear();
+        mUsedInLast = kSlotsPerChunk;
+        mFreeList = nullptr;
+    }
+};
+
+class MemberTable {
+private:
+    struct Slot {
+        size_t  hash;
+        Member* member;   // nullptr = 空槽 kTombstone = 已删除
+    };
+
+    static Member* tombstone() { return reinterpret_cast<Member*>(uintptr_t(1)); }
+
+    vector<Slot> mSlots;
+    size_t       mSize = 0;
+    size_t       mTombstones = 0;
+    MemberArena  mArena;
+
+private:
+    MemberTable(const MemberTable&);
+    MemberTable& operator=(const MemberTable&);
+
+    static size_t hashOf(string_view id) { return hash<string_view>()(id); }
+
+    bool live(const Slot& s) const { return s.member != nullptr && s.member != tombstone(); }
+
+    // 找 id 所在槽 找不到返回 npos
+    size_t findSlot(string_view id, size_t h) const {
+        if (mSlots.empty()) return npos;
+        size_t mask = mSlots.size() - 1;
+        for (size_t i = h & mask; ; i = (i + 1) & mask) {
+            const Slot& s = mSlots[i];
+            if (s.member == nullptr) return npos;
+            if (s.member != tombstone() && s.hash == h && s.member->getId() == id) return i;
+        }
+    }
+
+    // 新 key 的落脚槽：第一个空槽或墓碑
+    size_t insertSlot(size_t h) const {
+        size_t mask = mSlots.size() - 1;
+        for (size_t i = h & mask; ; i = (i + 1) & mask) {
+            if (!live(mSlots[i])) return i;
+        }
+    }
+
+    // 装载率（含墓碑）超过 0.7 就扩容/重建
+    void reserveForInsert() {
+        if (!mSlots.empty() && (mSize + mTombstones + 1) * 10 <= mSlots.size() * 7) return;
+
+        size_t cap = 16;
+        while (cap * 7 < (mSize + 1) * 10 * 2) cap <<= 1; // 重建后留一半余量
+        vector<Slot> old;
+        old.swap(mSlots);
+        mSlots.assign(cap, Slot{0, nullptr});
+        mTombstones = 0;
+        for (size_t i = 0; i < old.size(); ++i) {
+            if (live(old[i])) mSlots[insertSlot(old[i].hash)] = old[i];
+        }
+    }
+
+public:
+    static const size_t npos = static_cast<size_t>(-1);
+
+    MemberTable() {}
+    ~MemberTable() { clear(); }
+
+    size_t size() const { return mSize; }
+    bool empty() const { return mSize == 0; }
+
+    Member* find(string_view id) const {
+        size_t i = findSlot(id, hashOf(id));
+        return i == npos ? nullptr : mSlots[i].member;
+    }
+
+    bool contains(string_view id) const { return find(id) != nullptr; }
+
+    // 在 arena 里构造会员
+    // id 已存在时：replace 为 true 则替换旧对象 否则不插入 返回 nullptr
+    Member* emplace(int levelCode, const string& id, const string& name, const string& phone,
+                    int points, const string& joinDate, bool replace = false) {
+        size_t h = hashOf(id);
+        size_t i = findSlot(id, h);
+        if (i != npos) {
+            if (!replace) return nullptr;
+            Member* old = mSlots[i].member;
+            old->~Member();
+            Member* m = createMemberByLevel(old, levelCode, id, name, phone, points, joinDate);
+            mSlots[i].member = m;
+            return m;
+        }
+
+        reserveForInsert();
+        i = insertSlot(h);
+        if (mSlots[i].member == tombstone()) --mTombstones;
+        Member* m = createMemberByLevel(mArena.allocate(), levelCode, id, name, phone, points, joinDate);
+        mSlots[i] = Slot{h, m};
+        ++mSize;
+        return m;
+    }
+
+    // 析构对象 槽还给 arena 哈希槽留墓碑
+    bool erase(string_view id) {
+        size_t i = findSlot(id, hashOf(id));
+        if (i == npos) return false;
+        Member* m = mSlots[i].member;
+        m->~Member();
+        mArena.release(m);
+        mSlots[i].member = tombstone();
+        --mSize;
+        ++mTombstones;
+        return true;
+    }
+
+    // fn(Member*) 顺序是槽顺序（不是按 id 排序）
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        for (size_t i = 0; i < mSlots.size(); ++i) {
+            if (live(mSlots[i])) fn(mSlots[i].member);
+        }
+    }
+
+    void clear() {
+        for (size_t i = 0; i < mSlots.size(); ++i) {
+            if (live(mSlots[i])) mSlots[i].member->~Member();
+        }
+        mSlots.clear();
+        mSize = 0;
+        mTombstones = 0;
+        mArena.clear();
+    }
+};
@@ -0,0 +1,123 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <ostream>
+#include <cstdlib>
+#include <cmath>
+
+using namespace std;
+
+/*
+ * 金额（定点数 单位：分）
+ * - 内部是 long long 分 加减/比较/求和都是整数运算 不会有 0.1+0.2 的误差
+ * - 解析：from_chars 读整数部分 + 手动读最多两位小数（第三位四舍五入）
+ *         科学计数法等少见写法回退到 strtod（兼容旧文件里 atof 能读的内容）
+ * - 输出：to_chars 拼 "123.45" 不经过 iostream 的 locale / setprecision
+ */
+
+class Money {
+private:
+    long long mCents;
+
+    explicit Money(long long cents) : mCents(cents) {}
+
+public:
+    Money() : mCents(0) {}
+
+    static Money fromCents(long long cents) { return Money(cents); }
+
+    long long cents() const { return mCents; }
+
+    Money& operator+=(Money o) { mCents += o.mCents; return *this; }
+    Money& operator-=(Money o) { mCents -= o.mCents; return *this; }
+    friend Money operator+(Money a, Money b) { return Money(a.mCents + b.mCents); }
+    friend Money operator-(Money a, Money b) { return Money(a.mCents - b.mCents); }
+
+    friend bool operator==(Money a, Money b) { return a.mCents == b.mCents; }
+    friend bool operator!=(Money a, Money b) { return a.mCents != b.mCents; }
+    friend bool operator<(Money a, Money b) { return a.mCents < b.mCents; }
+    friend bool operator>(Money a, Money b) { return a.mCents > b.mCents; }
+    friend bool operator<=(Money a, Money b) { return a.mCents <= b.mCents; }
+    friend bool operator>=(Money a, Money b) { return a.mCents >= b.mCents; }
+
+    // 打折：percent 是整数百分比（95 = 九五折）结果四舍五入到分
+    Money applyPercent(int percent) const {
+        long long v = mCents * percent;
+        return Money(v >= 0 ? (v + 50) / 100 : -((-v + 50) / 100));
+    }
+
+    // 严格解析 整个字符串都必须是金额：[+-]digits[.digits]
+    static bool parse(string_view s, Money& out) {
+        const char* p = s.data();
+        const char* end = p + s.size();
+        if (p == end) return false;
+
+        bool neg = false;
+        if (*p == '+' || *p == '-') { neg = (*p == '-'); ++p; }
+        if (p == end) return false;
+
+        long long whole = 0;
+        bool anyDigit = (*p != '.');
+        if (*p != '.') {
+            from_chars_result r = from_chars(p, end, whole);
+            if (r.ec != errc() || whole < 0) return false;
+            p = r.ptr;
+        }
+
+        long long frac = 0;
+        if (p < end && *p == '.') {
+            ++p;
+            int digits = 0;
+            while (p < end && *p >= '0' && *p <= '9') {
+                if (digits < 2) frac = frac * 10 + (*p - '0');
+                else if (digits == 2 && *p >= '5') ++frac; // 第三位小数四舍五入
+                ++digits;
+                ++p;
+            }
+            if (digits > 0) anyDigit = true;
+            if (digits == 1) frac *= 10;
+        }
+        if (p != end || !anyDigit) return false;
+
+        long long cents = whole * 100 + frac;
+        out = Money(neg ? -cents : cents);
+        return true;
+    }
+
+    // 文件加载用：行为和 atof 一致 解析不了的按 0
+    static Money parseLenient(string_view s) {
+        Money m;
+        if (parse(s, m)) return m;
+
+        char buf[64];
+        if (s.size() >= sizeof(buf)) return Money();
+        s.copy(buf, s.size());
+        buf[s.size()] = '\0';
+        return Money(llround(strtod(buf, nullptr) * 100.0));
+    }
+
+    // 写到 buf 返回写入结尾 buf 至少 24 字节
+    char* format(char* buf) const {
+        unsigned long long v = mCents < 0 ? 0ULL - static_cast<unsigned long long>(mCents)
+                                          : static_cast<unsigned long long>(mCents);
+        char* p = buf;
+        if (mCents < 0) *p++ = '-';
+        p = to_chars(p, p + 21, v / 100).ptr;
+        unsigned frac = static_cast<unsigned>(v % 100);
+        *p++ = '.';
+        *p++ = static_cast<char>('0' + frac / 10);
+        *p++ = static_cast<char>('0' + frac % 10);
+        return p;
+    }
+
+    string toString() const {
+        char buf[32];
+        return string(buf, format(buf));
+    }
+
+    friend ostream& operator<<(ostream& os, Money m) {
+        char buf[32];
+        return os.write(buf, m.format(buf) - buf);
+    }
+};
@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <utility>
+
+using namespace std;
+
+/*
+ * 无锁多生产者单消费者队列（Vyukov 侵入式 MPSC 链表）
+ * - push：任意线程 一次 exchange 就把节点挂到队头 没有锁 没有 CAS 重试
+ * - pop / empty：只能由唯一的消费者线程调用
+ * - 生产者 exchange 之后、链接 next 之前的瞬间 pop 会暂时返回 false（队列并不空）
+ *   消费者用 empty() 判断是否真的没有数据（它看的是队头 能看到正在挂的节点）
+ *
+ * 节点用 new/delete 每个元素一次分配（配合 promise 本来也要分配 不是瓶颈）
+ */
+
+template <typename T>
+class MpscQueue {
+private:
+    struct Node {
+        atomic<Node*> next;
+        T value;
+
+        Node() : next(nullptr) {}
+        explicit Node(T&& v) : next(nullptr), value(std::move(v)) {}
+    };
+
+    atomic<Node*> mHead;   // 生产者往这里挂
+    Node*         mTail;   // 消费者从这里取（只有消费者访问）
+    Node          mStub;
+
+private:
+    MpscQueue(const MpscQueue&);
+    MpscQueue& operator=(const MpscQueue&);
+
+    void pushNode(Node* n) {
+        n->next.store(nullptr, memory_order_relaxed);
+        Node* prev = mHead.exchange(n, memory_order_seq_cst);
+        prev->next.store(n, memory_order_release);
+    }
+
+public:
+    MpscQueue() : mHead(&mStub), mTail(&mStub) {}
+
+    ~MpscQueue() {
+        T v;
+        while (pop(v)) {}
+    }
+
+    void push(T v) { pushNode(new Node(std::move(v))); }
+
+    // 只能由消费者调用
+    bool pop(T& out) {
+        Node* tail = mTail;
+        Node* next = tail->next.load(memory_order_acquire);
+        if (tail == &mStub) {
+            if (!next) return false;
+            mTail = next;
+            tail = next;
+            next = next->next.load(memory_order_acquire);
+        }
+        if (!next) {
+            // tail 是最后一个节点：把 stub 挂回去 才能把 tail 取走
+            if (tail != mHead.load(memory_order_acquire)) return false; // 生产者正在挂节点
+            pushNode(&mStub);
+            next = tail->next.load(memory_order_acquire);
+            if (!next) return false;
+        }
+        mTail = next;
+        out = std::move(tail->value);
+        delete tail;
+        return true;
+    }
+
+    // 只能由消费者调用 包括“已经 exchange 但还没链接好”的节点
+    bool empty() const {
+        return mTail == &mStub && mHead.load(memory_order_seq_cst) == &mStub;
+    }
+};
@@ -0,0 +1,114 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <utility>
+#include <cstddef>
+
+#include "simd_scan.h"
+
+using namespace std;
+
+/*
+ * 多线程分块加载
+ * 1) 整个文件一次读进内存
+ * 2) 按字节切成若干块 每块的边界向后对齐到下一个 '\n' 之后（不会把一行切成两半）
+ * 3) 固定数量的工作线程 用原子计数器领取块 各自解析到自己的块状态（行 + 线程私有的字符串字典）
+ * 4) 调用方按块号（也就是文件顺序）依次合并 结果和单线程 getline 逐行解析完全一致
+ *    planChunks 切块 + forEachChunkParallel 并行回调 合并由调用方做（见 transaction_store.h 的 loadFile）
+ *
+ * 行的切分规则和 getline 相同：以 '\n' 分行 最后一行没有 '\n' 也算一行
+ * 找 '\n' 走向量化扫描（simd_scan.h）
+ */
+
+namespace loader {
+
+    // 小于这个大小的文件直接单线程 开线程不划算
+    const size_t kParallelThreshold = 1 << 20;
+
+    inline bool readWholeFile(const string& path, string& out) {
+        ifstream fin(path.c_str(), ios::binary);
+        if (!fin) return false;
+
+        fin.seekg(0, ios::end);
+        streamoff size = fin.tellg();
+        fin.seekg(0, ios::beg);
+        if (size < 0) return false;
+
+        out.resize(static_cast<size_t>(size));
+        if (size > 0) fin.read(&out[0], size);
+        return true;
+    }
+
+    // [begin, end) 的块列表 除最后一块外 每块都以 '\n' 结尾
+    inline vector<pair<size_t, size_t>> splitChunks(const string& data, size_t parts) {
+        vector<pair<size_t, size_t>> chunks;
+        if (data.empty()) return chunks;
+        if (parts == 0) parts = 1;
+
+        size_t target = data.size() / parts + 1;
+        size_t begin = 0;
+        while (begin < data.size()) {
+            size_t end = begin + target;
+            if (end >= data.size()) {
+                end = data.size();
+            } else {
+                const char* last = data.data() + data.size();
+                const char* nl = simd::findByte(data.data() + end, last, '\n');
+                end = (nl == last) ? data.size() : static_cast<size_t>(nl - data.data()) + 1;
+            }
+            chunks.push_back(make_pair(begin, end));
+            begin = end;
+        }
+        return chunks;
+    }
+
+    inline unsigned defaultThreadCount() {
+        unsigned n = thread::hardware_concurrency();
+        return n == 0 ? 1 : n;
+    }
+
+    // 逐行回调 fn(const char* b, const char* e)（不含 '\n'）
+    template <typename Fn>
+    void forEachLine(const char* b, const char* e, Fn&& fn) {
+        while (b < e) {
+            const char* nl = simd::findByte(b, e, '\n');
+            fn(b, nl);
+            b = (nl < e) ? nl + 1 : e;
+        }
+    }
+
+    // 按线程数切块（小文件只切一块 threads 同时改成 1）
+    // 块数多于线程数 负载不均时快的线程可以多领几块
+    inline vector<pair<size_t, size_t>> planChunks(const string& data, unsigned& threads) {
+        if (threads == 0) threads = 1;
+        if (data.size() < kParallelThreshold) threads = 1;
+        return splitChunks(data, threads == 1 ? 1 : threads * 4);
+    }
+
+    // 并行回调 fn(size_t chunkIndex, const char* b, const char* e)
+    // 调用方按块号 0..n-1 的顺序合并就是文件顺序
+    template <typename ChunkFn>
+    void forEachChunkParallel(const string& data, const vector<pair<size_t, size_t>>& chunks,
+                              ChunkFn fn, unsigned threads) {
+        atomic<size_t> nextChunk(0);
+        auto worker = [&]() {
+            while (true) {
+                size_t c = nextChunk.fetch_add(1);
+                if (c >= chunks.size()) break;
+                fn(c, data.data() + chunks[c].first, data.data() + chunks[c].second);
+            }
+        };
+
+        if (threads <= 1 || chunks.size() <= 1) {
+            worker();
+        } else {
+            vector<thread> pool;
+            for (unsigned i = 0; i < threads; ++i) pool.push_back(thread(worker));
+            for (size_t i = 0; i < pool.size(); ++i) pool[i].join();
+        }
+    }
+
+}
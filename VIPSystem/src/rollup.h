@@ -0,0 +1,183 @@
+#pragma once
+#include <vector>
+#include <map>
+#include <thread>
+#include <utility>
+#include <cstdint>
+
+#include "transaction.h"
+#include "transaction_columns.h"
+#include "money.h"
+
+using namespace std;
+
+/*
+ * 营收汇总（物化）：按 日 / 月 × 会员等级 累计 笔数 / 原价 / 实付 / 积分
+ * - 日桶 key = dateKey(yyyymmdd) 月桶 key = yyyymm 每个桶里 3 个等级各一格
+ * - 新消费 add 删除会员 remove 两者都是 O(log 桶数) 报表不再扫交易表
+ * - 全量重建（加载后）并行归约：交易表切成 threads 段 每个线程先汇总到自己的局部 map
+ *   最后按段号合并（加法可交换 合并顺序不影响结果）
+ * 等级取消费时会员的等级（会员等级创建后不会改）调用方传入
+ */
+
+struct RollupCell {
+    size_t    count = 0;
+    Money     amount;
+    Money     pay;
+    long long points = 0;
+
+    void add(const Transaction& t) {
+        ++count;
+        amount += t.amount;
+        pay += t.pay;
+        points += t.pointsEarned;
+    }
+
+    void remove(const Transaction& t) {
+        --count;
+        amount -= t.amount;
+        pay -= t.pay;
+        points -= t.pointsEarned;
+    }
+
+    void merge(const RollupCell& o) {
+        count += o.count;
+        amount += o.amount;
+        pay += o.pay;
+        points += o.points;
+    }
+};
+
+// 一个桶：按等级（0 普通 1 VIP 2 SVIP）分开
+struct RollupBucket {
+    static const int kLevels = 3;
+    RollupCell level[kLevels];
+
+    RollupCell total() const {
+        RollupCell t;
+        for (int i = 0; i < kLevels; ++i) t.merge(level[i]);
+        return t;
+    }
+
+    void merge(const RollupBucket& o) {
+        for (int i = 0; i < kLevels; ++i) level[i].merge(o.level[i]);
+    }
+};
+
+class RevenueRollup {
+public:
+    enum Granularity { kDay, kMonth };
+
+private:
+    map<int, RollupBucket> mDays;
+    map<int, RollupBucket> mMonths;
+
+    static int clampLevel(int levelCode) {
+        return (levelCode < 0 || levelCode >= RollupBucket::kLevels) ? 0 : levelCode;
+    }
+
+    const map<int, RollupBucket>& buckets(Granularity g) const { return g == kDay ? mDays : mMonths; }
+
+public:
+    void clear() {
+        mDays.clear();
+        mMonths.clear();
+    }
+
+    void add(const Transaction& t, int levelCode) {
+        const int lv = clampLevel(levelCode);
+        mDays[t.dateKey].level[lv].add(t);
+        mMonths[t.dateKey / 100].level[lv].add(t);
+    }
+
+    // 删除会员时逐条减回去 笔数归零的桶删掉
+    void remove(const Transaction& t, int levelCode) {
+        const int lv = clampLevel(levelCode);
+        removeFrom(mDays, t.dateKey, lv, t);
+        removeFrom(mMonths, t.dateKey / 100, lv, t);
+    }
+
+    // 直接并入一格（二进制快照里存的日汇总 见 mapped_store.h）
+    void addCell(int dateKey, int levelCode, const RollupCell& c) {
+        const int lv = clampLevel(levelCode);
+        mDays[dateKey].level[lv].merge(c);
+        mMonths[dateKey / 100].level[lv].merge(c);
+    }
+
+    // levelOf[memberHandle] = 等级 超出范围按普通会员
+    void rebuild(const TransactionColumns& rows, const vector<int>& levelOf, unsigned threads) {
+        clear();
+        if (threads == 0) threads = 1;
+        // 行数少时开线程不划算
+        if (rows.size() < 100000) threads = 1;
+
+        vector<RevenueRollup> parts(threads);
+        auto reduce = [&](unsigned p) {
+            const size_t begin = rows.size() * p / threads;
+            const size_t end = rows.size() * (p + 1) / threads;
+            RevenueRollup& part = parts[p];
+            Transaction t;   // 只拼数值字段 汇总用不到 date
+            for (size_t i = begin; i < end; ++i) {
+                rows.loadNumeric(i, t);
+                part.add(t, t.memberHandle < levelOf.size() ? levelOf[t.memberHandle] : 0);
+            }
+        };
+
+        if (threads == 1) {
+            reduce(0);
+        } else {
+            vector<thread> pool;
+            for (unsigned p = 0; p < threads; ++p) pool.push_back(thread(reduce, p));
+            for (size_t i = 0; i < pool.size(); ++i) pool[i].join();
+        }
+
+        for (unsigned p = 0; p < threads; ++p) {
+            mergeInto(mDays, parts[p].mDays);
+            mergeInto(mMonths, parts[p].mMonths);
+        }
+    }
+
+    // [fromKey, toKey] 的桶 按 key 升序 key 是 yyyymmdd（日）或 yyyymm（月）
+    // 月粒度时传入的仍是日期 只看年月部分
+    vector<pair<int, RollupBucket>> between(Granularity g, int fromKey, int toKey) const {
+        if (g == kMonth) { fromKey /= 100; toKey /= 100; }
+        vector<pair<int, RollupBucket>> out;
+        if (fromKey > toKey) return out;
+        const map<int, RollupBucket>& b = buckets(g);
+        for (auto it = b.lower_bound(fromKey); it != b.end() && it->first <= toKey; ++it) out.push_back(*it);
+        return out;
+    }
+
+    // 区间内按等级合计（整月落在区间里的用月桶 两头不完整的月用日桶）
+    RollupBucket total(int fromKey, int toKey) const {
+        RollupBucket sum;
+        if (fromKey > toKey) return sum;
+        const int firstFullMonth = (fromKey % 100 <= 1) ? fromKey / 100 : fromKey / 100 + 1;
+        const int lastFullMonth = (toKey % 100 >= 31) ? toKey / 100 : toKey / 100 - 1;
+        if (firstFullMonth > lastFullMonth) {
+            sumRange(mDays, fromKey, toKey, sum);
+            return sum;
+        }
+        sumRange(mDays, fromKey, firstFullMonth * 100 - 1, sum);
+        sumRange(mMonths, firstFullMonth, lastFullMonth, sum);
+        sumRange(mDays, (lastFullMonth + 1) * 100, toKey, sum);
+        return sum;
+    }
+
+private:
+    static void removeFrom(map<int, RollupBucket>& m, int key, int lv, const Transaction& t) {
+        auto it = m.find(key);
+        if (it == m.end()) return;
+        it->second.level[lv].remove(t);
+        if (it->second.total().count == 0) m.erase(it);
+    }
+
+    static void mergeInto(map<int, RollupBucket>& dst, const map<int, RollupBucket>& src) {
+        for (auto it = src.begin(); it != src.end(); ++it) dst[it->first].merge(it->second);
+    }
+
+    static void sumRange(const map<int, RollupBucket>& m, int fromKey, int toKey, RollupBucket& sum) {
+        if (fromKey > toKey) return;
+        for (auto it = m.lower_bound(fromKey); it != m.end() && it->first <= toKey; ++it) sum.merge(it->second);
+    }
+};
@@ -0,0 +1,272 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <unistd.h>
+
+#include "transaction.h"
+#include "parallel_loader.h"
+#include "durable_file.h"
+#include "utility.h"
+
+using namespace std;
+
+/*
+ * 归档段文件（列式 只读）：冷数据从 transactions.txt 里封存出来 一段一个文件 写完不再修改
+ *
+ * 布局（整数全部是 LEB128 varint 有符号的先 zigzag）：
+ *   "VIPSEG01"                                    8 字节魔数
+ *   头：版本 | 行数 | 最小/最大 dateKey | 最小/最大交易号
+ *   会员号字典 | 商品字典                          条数 + (长度 + 字节)...   段内编号从 0 开始
+ *   列 × 8：每列先写字节数 再写内容
+ *     交易号      与上一行的差值
+ *     dateKey     与上一行的差值
+ *     会员号编号  段内字典编号
+ *     商品编号    段内字典编号
+ *     原价        分
+ *     折扣金额    原价 - 实付（分 通常比实付小得多）
+ *     积分
+ *     日期例外    date 字符串不是 dateKey 的标准写法时（空 / 非法日期）单独存：条数 + (行号 + 字符串)...
+ *   FNV-1a 64 校验和                              8 字节 覆盖前面全部内容
+ *
+ * 一行通常 10 字节左右（文本大约 60 字节）读的时候不用逐字节找 '|' 也不用解析十进制小数
+ */
+
+namespace segment {
+
+    const char kMagic[8] = { 'V', 'I', 'P', 'S', 'E', 'G', '0', '1' };
+    const uint64_t kVersion = 1;
+
+    struct Header {
+        uint64_t rows = 0;
+        int      minDateKey = 0;
+        int      maxDateKey = 0;
+        long     minTransactionId = 0;
+        long     maxTransactionId = 0;
+    };
+
+    inline uint64_t zigzag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+    inline int64_t unzigzag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+    inline void putVarint(string& out, uint64_t v) {
+        while (v >= 0x80) {
+            out += static_cast<char>((v & 0x7F) | 0x80);
+            v >>= 7;
+        }
+        out += static_cast<char>(v);
+    }
+
+    inline void putSigned(string& out, int64_t v) { putVarint(out, zigzag(v)); }
+
+    inline void putString(string& out, string_view s) {
+        putVarint(out, s.size());
+        out.append(s.data(), s.size());
+    }
+
+    inline uint64_t fnv1a(const char* p, size_t n) {
+        uint64_t h = 1469598103934665603ULL;
+        for (size_t i = 0; i < n; ++i) {
+            h ^= static_cast<unsigned char>(p[i]);
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+    // 顺序读 越界 / 格式错误后 ok() 变成 false 之后读到的都是 0
+    class Reader {
+    private:
+        const char* mPos;
+        const char* mEnd;
+        bool        mOk = true;
+
+    public:
+        Reader(const char* b, const char* e) : mPos(b), mEnd(e) {}
+
+        bool ok() const { return mOk; }
+        bool atEnd() const { return mPos == mEnd; }
+        size_t remaining() const { return static_cast<size_t>(mEnd - mPos); }
+
+        uint64_t varint() {
+            uint64_t v = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7) {
+                if (mPos == mEnd) { mOk = false; return 0; }
+                unsigned char c = static_cast<unsigned char>(*mPos++);
+                v |= static_cast<uint64_t>(c & 0x7F) << shift;
+                if (!(c & 0x80)) return v;
+            }
+            mOk = false;
+            return 0;
+        }
+
+        int64_t signedVarint() { return unzigzag(varint()); }
+
+        string_view bytes(uint64_t n) {
+            if (n > static_cast<uint64_t>(mEnd - mPos)) { mOk = false; mPos = mEnd; return string_view(); }
+            string_view s(mPos, static_cast<size_t>(n));
+            mPos += n;
+            return s;
+        }
+
+        // 一列：字节数 + 内容 返回只覆盖该列的子 Reader
+        Reader column() {
+            string_view s = bytes(varint());
+            return Reader(s.data(), s.data() + s.size());
+        }
+    };
+
+    // rows 写成一个段文件（先写 path.tmp fsync 再 rename + 目录 fsync）dicts 是 rows 所在存储的字典
+    // 返回写入字节数 失败返回 0
+    inline size_t write(const string& path, const vector<const Transaction*>& rows,
+                        const TransactionDicts& dicts, Header* headerOut = nullptr) {
+        Header h;
+        h.rows = rows.size();
+        if (!rows.empty()) {
+            h.minDateKey = h.maxDateKey = rows[0]->dateKey;
+            h.minTransactionId = h.maxTransactionId = rows[0]->transactionId;
+        }
+
+        // 全局编号 -> 段内编号 只收录本段用到的字符串
+        vector<uint32_t> memberCode(dicts.memberIds.size(), StringDict::kNone);
+        vector<uint32_t> itemCode(dicts.items.size(), StringDict::kNone);
+        vector<uint32_t> members, items;   // 段内编号 -> 全局编号
+        string colTx, colDate, colMember, colItem, colAmount, colDiscount, colPoints, colDateText;
+        vector<pair<uint64_t, string_view>> dateExceptions;
+
+        long prevTx = 0;
+        int prevDate = 0;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            const Transaction& t = *rows[i];
+            if (t.dateKey < h.minDateKey) h.minDateKey = t.dateKey;
+            if (t.dateKey > h.maxDateKey) h.maxDateKey = t.dateKey;
+            if (t.transactionId < h.minTransactionId) h.minTransactionId = t.transactionId;
+            if (t.transactionId > h.maxTransactionId) h.maxTransactionId = t.transactionId;
+
+            uint32_t& mc = memberCode[t.memberHandle];
+            if (mc == StringDict::kNone) { mc = static_cast<uint32_t>(members.size()); members.push_back(t.memberHandle); }
+            uint32_t& ic = itemCode[t.itemCode];
+            if (ic == StringDict::kNone) { ic = static_cast<uint32_t>(items.size()); items.push_back(t.itemCode); }
+
+            putSigned(colTx, t.transactionId - prevTx);
+            putSigned(colDate, t.dateKey - prevDate);
+            putVarint(colMember, mc);
+            putVarint(colItem, ic);
+            putSigned(colAmount, t.amount.cents());
+            putSigned(colDiscount, t.amount.cents() - t.pay.cents());
+            putSigned(colPoints, t.pointsEarned);
+            if (t.date != util::intToDate(t.dateKey)) dateExceptions.push_back(make_pair(i, string_view(t.date)));
+
+            prevTx = t.transactionId;
+            prevDate = t.dateKey;
+        }
+        putVarint(colDateText, dateExceptions.size());
+        for (size_t i = 0; i < dateExceptions.size(); ++i) {
+            putVarint(colDateText, dateExceptions[i].first);
+            putString(colDateText, dateExceptions[i].second);
+        }
+
+        string out(kMagic, sizeof(kMagic));
+        putVarint(out, kVersion);
+        putVarint(out, h.rows);
+        putSigned(out, h.minDateKey);
+        putSigned(out, h.maxDateKey);
+        putSigned(out, h.minTransactionId);
+        putSigned(out, h.maxTransactionId);
+        putVarint(out, members.size());
+        for (size_t i = 0; i < members.size(); ++i) putString(out, dicts.memberIds.str(members[i]));
+        putVarint(out, items.size());
+        for (size_t i = 0; i < items.size(); ++i) putString(out, dicts.items.str(items[i]));
+        const string* cols[] = { &colTx, &colDate, &colMember, &colItem, &colAmount, &colDiscount, &colPoints, &colDateText };
+        for (size_t c = 0; c < sizeof(cols) / sizeof(cols[0]); ++c) putString(out, *cols[c]);
+
+        uint64_t sum = fnv1a(out.data(), out.size());
+        for (int i = 0; i < 8; ++i) out += static_cast<char>((sum >> (8 * i)) & 0xFF);
+
+        const string tmp = path + ".tmp";
+        FILE* f = fopen(tmp.c_str(), "wb");
+        if (!f) return 0;
+        bool ok = fwrite(out.data(), 1, out.size(), f) == out.size();
+        ok = (fflush(f) == 0) && ok;
+        ok = (fsync(fileno(f)) == 0) && ok;
+        fclose(f);
+        if (!ok || rename(tmp.c_str(), path.c_str()) != 0 || !durable::syncDir(path)) return 0;
+
+        if (headerOut) *headerOut = h;
+        return out.size();
+    }
+
+    // 读回整段：rows 的 memberHandle / itemCode 是 dicts 里的编号（段内字典原样载入）
+    // 魔数 / 校验和 / 行数对不上都返回 false
+    inline bool read(const string& path, vector<Transaction>& rows, TransactionDicts& dicts,
+                     Header& h, size_t* bytesRead = nullptr) {
+        string data;
+        if (!loader::readWholeFile(path, data)) return false;
+        if (bytesRead) *bytesRead = data.size();
+        if (data.size() < sizeof(kMagic) + 8 || memcmp(data.data(), kMagic, sizeof(kMagic)) != 0) return false;
+
+        const size_t bodyEnd = data.size() - 8;
+        uint64_t sum = 0;
+        for (int i = 0; i < 8; ++i) sum |= static_cast<uint64_t>(static_cast<unsigned char>(data[bodyEnd + i])) << (8 * i);
+        if (sum != fnv1a(data.data(), bodyEnd)) return false;
+
+        Reader in(data.data() + sizeof(kMagic), data.data() + bodyEnd);
+        if (in.varint() != kVersion) return false;
+        h.rows = in.varint();
+        h.minDateKey = static_cast<int>(in.signedVarint());
+        h.maxDateKey = static_cast<int>(in.signedVarint());
+        h.minTransactionId = static_cast<long>(in.signedVarint());
+        h.maxTransactionId = static_cast<long>(in.signedVarint());
+
+        dicts.clear();
+        uint64_t n = in.varint();
+        for (uint64_t i = 0; i < n && in.ok(); ++i) dicts.memberIds.intern(in.bytes(in.varint()));
+        n = in.varint();
+        for (uint64_t i = 0; i < n && in.ok(); ++i) dicts.items.intern(in.bytes(in.varint()));
+
+        Reader colTx = in.column(), colDate = in.column(), colMember = in.column(), colItem = in.column();
+        Reader colAmount = in.column(), colDiscount = in.column(), colPoints = in.column(), colDateText = in.column();
+        if (!in.ok() || !in.atEnd()) return false;
+        if (h.rows > colTx.remaining()) return false;   // 每行至少 1 字节 防止损坏的行数撑爆内存
+
+        const size_t first = rows.size();
+        rows.resize(first + h.rows);
+        long tx = 0;
+        int date = 0;
+        int cachedKey = -1;
+        string cachedDate;   // 相邻行大多同一天 日期字符串只格式化一次
+        for (uint64_t i = 0; i < h.rows; ++i) {
+            Transaction& t = rows[first + i];
+            tx += static_cast<long>(colTx.signedVarint());
+            date += static_cast<int>(colDate.signedVarint());
+            t.transactionId = tx;
+            t.dateKey = date;
+            if (date != cachedKey) { cachedKey = date; cachedDate = util::intToDate(date); }
+            t.date = cachedDate;
+            t.memberHandle = static_cast<uint32_t>(colMember.varint());
+            t.itemCode = static_cast<uint32_t>(colItem.varint());
+            long long amount = colAmount.signedVarint();
+            t.amount = Money::fromCents(amount);
+            t.pay = Money::fromCents(amount - colDiscount.signedVarint());
+            t.pointsEarned = static_cast<int>(colPoints.signedVarint());
+            if (t.memberHandle >= dicts.memberIds.size() || t.itemCode >= dicts.items.size()) {
+                rows.resize(first);
+                return false;
+            }
+        }
+        uint64_t exceptions = colDateText.varint();
+        for (uint64_t i = 0; i < exceptions && colDateText.ok(); ++i) {
+            uint64_t row = colDateText.varint();
+            string_view s = colDateText.bytes(colDateText.varint());
+            if (row < h.rows) rows[first + row].date.assign(s.data(), s.size());
+        }
+
+        if (!colTx.ok() || !colDate.ok() || !colMember.ok() || !colItem.ok() || !colAmount.ok()
+            || !colDiscount.ok() || !colPoints.ok() || !colDateText.ok()) {
+            rows.resize(first);
+            return false;
+        }
+        return true;
+    }
+}
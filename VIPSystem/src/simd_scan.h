@@ -0,0 +1,210 @@
+#pragma once
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VIP_SIMD_X86 1
+#endif
+
+/*
+ * 向量化字节扫描：找字段分隔符 '|' 和行尾 '\n'；跳过空白（' ' '\t' '\r' '\n' 一类字节 trim 用）
+ * - 空白类：每个向量比较 4 次 OR 起来 取反后第一个（往回跳时最后一个）置位的字节就是非空白
+ * - AVX2：一次比较 32 字节
+ * - SSE2：一次比较 16 字节（x86-64 必定支持）
+ * - 标量：其它平台 / 剩余不足一个向量的尾巴
+ *
+ * 运行时分派：第一次调用时用 __builtin_cpu_supports 检测 CPU
+ * 选出的实现存成函数指针 之后每次调用只多一次间接跳转
+ * 只用非对齐 load 且不越过 end 读 调用方不需要额外的缓冲区填充
+ */
+
+namespace simd {
+
+    enum Level { kScalar = 0, kSse2 = 1, kAvx2 = 2 };
+
+    // 在 [p, end) 找第一个 c 找不到返回 end
+    typedef const char* (*FindByteFn)(const char* p, const char* end, char c);
+    // [p, end) 里第一个非空白字节 全是空白返回 end
+    typedef const char* (*SkipSpaceFn)(const char* p, const char* end);
+    // 从 end 往回跳过空白 返回 q：[q, end) 全是空白 且 q == begin 或 q[-1] 不是空白
+    typedef const char* (*SkipSpaceBackFn)(const char* begin, const char* end);
+
+    namespace detail {
+
+        inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+        inline const char* findByteScalar(const char* p, const char* end, char c) {
+            while (p < end && *p != c) ++p;
+            return p;
+        }
+
+        inline const char* skipSpaceScalar(const char* p, const char* end) {
+            while (p < end && isSpace(*p)) ++p;
+            return p;
+        }
+
+        inline const char* skipSpaceBackScalar(const char* begin, const char* end) {
+            while (end > begin && isSpace(end[-1])) --end;
+            return end;
+        }
+
+#if defined(VIP_SIMD_X86)
+        __attribute__((target("sse2")))
+        inline const char* findByteSse2(const char* p, const char* end, char c) {
+            const __m128i needle = _mm_set1_epi8(c);
+            while (end - p >= 16) {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+                if (mask != 0) return p + __builtin_ctz(static_cast<unsigned>(mask));
+                p += 16;
+            }
+            return findByteScalar(p, end, c);
+        }
+
+        // 非空白字节的位掩码（低 16 位）
+        __attribute__((target("sse2")))
+        inline unsigned nonSpaceMask16(const char* p) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i space = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\t')));
+            space = _mm_or_si128(space, _mm_cmpeq_epi8(block, _mm_set1_epi8('\r')));
+            space = _mm_or_si128(space, _mm_cmpeq_epi8(block, _mm_set1_epi8('\n')));
+            return ~static_cast<unsigned>(_mm_movemask_epi8(space)) & 0xFFFFu;
+        }
+
+        __attribute__((target("sse2")))
+        inline const char* skipSpaceSse2(const char* p, const char* end) {
+            while (end - p >= 16) {
+                const unsigned mask = nonSpaceMask16(p);
+                if (mask != 0) return p + __builtin_ctz(mask);
+                p += 16;
+            }
+            return skipSpaceScalar(p, end);
+        }
+
+        __attribute__((target("sse2")))
+        inline const char* skipSpaceBackSse2(const char* begin, const char* end) {
+            while (end - begin >= 16) {
+                const unsigned mask = nonSpaceMask16(end - 16);
+                if (mask != 0) return end - 16 + (32 - __builtin_clz(mask));
+                end -= 16;
+            }
+            return skipSpaceBackScalar(begin, end);
+        }
+
+        __attribute__((target("avx2")))
+        inline const char* findByteAvx2(const char* p, const char* end, char c) {
+            const __m256i needle = _mm256_set1_epi8(c);
+            while (end - p >= 32) {
+                __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle)));
+                if (mask != 0) return p + __builtin_ctz(mask);
+                p += 32;
+            }
+            return findByteSse2(p, end, c);
+        }
+
+        __attribute__((target("avx2")))
+        inline unsigned nonSpaceMask32(const char* p) {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')),
+                                            _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\t')));
+            space = _mm256_or_si256(space, _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\r')));
+            space = _mm256_or_si256(space, _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n')));
+            return ~static_cast<unsigned>(_mm256_movemask_epi8(space));
+        }
+
+        __attribute__((target("avx2")))
+        inline const char* skipSpaceAvx2(const char* p, const char* end) {
+            while (end - p >= 32) {
+                const unsigned mask = nonSpaceMask32(p);
+                if (mask != 0) return p + __builtin_ctz(mask);
+                p += 32;
+            }
+            return skipSpaceSse2(p, end);
+        }
+
+        __attribute__((target("avx2")))
+        inline const char* skipSpaceBackAvx2(const char* begin, const char* end) {
+            while (end - begin >= 32) {
+                const unsigned mask = nonSpaceMask32(end - 32);
+                if (mask != 0) return end - 32 + (32 - __builtin_clz(mask));
+                end -= 32;
+            }
+            return skipSpaceBackSse2(begin, end);
+        }
+#endif
+
+        inline Level detectLevel() {
+#if defined(VIP_SIMD_X86)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) return kAvx2;
+            if (__builtin_cpu_supports("sse2")) return kSse2;
+#endif
+            return kScalar;
+        }
+
+        inline FindByteFn findByteFor(Level level) {
+#if defined(VIP_SIMD_X86)
+            if (level == kAvx2) return findByteAvx2;
+            if (level == kSse2) return findByteSse2;
+#else
+            (void)level;
+#endif
+            return findByteScalar;
+        }
+
+        struct Dispatch {
+            Level           level;
+            FindByteFn      findByte;
+            SkipSpaceFn     skipSpace;
+            SkipSpaceBackFn skipSpaceBack;
+        };
+
+        inline Dispatch dispatchFor(Level level) {
+            Dispatch d = { level, findByteFor(level), skipSpaceScalar, skipSpaceBackScalar };
+#if defined(VIP_SIMD_X86)
+            if (level == kAvx2) {
+                d.skipSpace = skipSpaceAvx2;
+                d.skipSpaceBack = skipSpaceBackAvx2;
+            } else if (level == kSse2) {
+                d.skipSpace = skipSpaceSse2;
+                d.skipSpaceBack = skipSpaceBackSse2;
+            }
+#endif
+            return d;
+        }
+
+        inline Dispatch& dispatch() {
+            static Dispatch d = dispatchFor(detectLevel());
+            return d;
+        }
+
+    }
+
+    inline Level activeLevel() { return detail::dispatch().level; }
+
+    inline const char* levelName(Level level) {
+        if (level == kAvx2) return "avx2";
+        if (level == kSse2) return "sse2";
+        return "scalar";
+    }
+
+    // 基准测试用：强制切换实现（不能超过 CPU 实际支持的级别）
+    inline void forceLevel(Level level) {
+        if (level > detail::detectLevel()) level = detail::detectLevel();
+        detail::dispatch() = detail::dispatchFor(level);
+    }
+
+    inline const char* findByte(const char* p, const char* end, char c) {
+        return detail::dispatch().findByte(p, end, c);
+    }
+
+    inline const char* skipSpace(const char* p, const char* end) {
+        return detail::dispatch().skipSpace(p, end);
+    }
+
+    inline const char* skipSpaceBack(const char* begin, const char* end) {
+        return detail::dispatch().skipSpaceBack(begin, end);
+    }
+
+}
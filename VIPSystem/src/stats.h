@@ -0,0 +1,303 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <ctime>
+
+#include "histogram.h"
+
+using namespace std;
+
+/*
+ * 运行统计：每种操作的延迟直方图 + 次数 以及 读/写字节数、扫描行数
+ *
+ * 记录：
+ * - VIP_STATS_TIMER(stats::kPurchase)   作用域计时 析构时记一次
+ * - VIP_STATS_ADD(stats::kRowsScanned, n)
+ * - 每个线程一份计数（thread_local）只有本线程写 不加锁 不用 lock 前缀的原子加
+ *   读的时候（STATS 命令 / 菜单 / 定时转储）再把所有线程的合并起来
+ *   线程退出时它的计数并入 “已退出线程” 那一份 不会丢
+ *
+ * 编译开关：-DVIP_NO_STATS 时上面两个宏展开为空（参数也不求值）记录代码完全不存在
+ *           report() 之类的查看接口仍然在 只是返回 “统计未编译”
+ *
+ * 查看：菜单 8 / STATS 命令 / --stats-dump 文件 秒数（StatsDumper 定时追加）
+ */
+
+namespace stats {
+
+    enum Op {
+        kLoad,
+        kSave,
+        kAddMember,
+        kEditMember,
+        kDeleteMember,
+        kPurchase,
+        kIngest,        // 入队到 future 兑现
+        kQueryMember,
+        kMemberTransactions,   // 会员交易明细（和汇总查询分开计 明细要遍历 耗时差得多）
+        kQueryRange,
+        kItemReport,
+        kLeaderboard,
+        kRollup,
+        kImport,        // 批量导入的一批（见 bulk_import.h）
+        kOpCount
+    };
+
+    enum Counter {
+        kBytesRead,
+        kBytesWritten,
+        kRowsScanned,
+        kCounterCount
+    };
+
+    inline const char* opName(int op) {
+        static const char* kNames[kOpCount] = {
+            "load", "save", "add_member", "edit_member", "delete_member",
+            "purchase", "ingest", "query_member", "member_transactions", "query_range", "item_report",
+            "leaderboard", "rollup", "import"
+        };
+        return kNames[op];
+    }
+
+    inline const char* counterName(int c) {
+        static const char* kNames[kCounterCount] = { "bytes_read", "bytes_written", "rows_scanned" };
+        return kNames[c];
+    }
+
+    // 850ns / 12.3us / 4.56ms / 1.23s
+    inline string formatNs(uint64_t ns) {
+        char buf[32];
+        if (ns < 1000) snprintf(buf, sizeof(buf), "%lluns", static_cast<unsigned long long>(ns));
+        else if (ns < 1000000) snprintf(buf, sizeof(buf), "%.1fus", ns / 1e3);
+        else if (ns < 1000000000) snprintf(buf, sizeof(buf), "%.2fms", ns / 1e6);
+        else snprintf(buf, sizeof(buf), "%.2fs", ns / 1e9);
+        return buf;
+    }
+
+    // 合并后的结果（普通数组 随便读）
+    struct Snapshot {
+        LatencyHistogram ops[kOpCount];
+        uint64_t counters[kCounterCount] = {};
+    };
+
+    // 多行表格（菜单 / 转储文件）
+    inline string formatTable(const Snapshot& s) {
+        string out;
+        char line[160];
+        snprintf(line, sizeof(line), "%-14s %10s %9s %9s %9s %9s %9s\n",
+                 "op", "count", "mean", "p50", "p99", "p999", "max");
+        out += line;
+        for (int op = 0; op < kOpCount; ++op) {
+            const LatencyHistogram& h = s.ops[op];
+            if (h.count() == 0) continue;
+            snprintf(line, sizeof(line), "%-14s %10llu %9s %9s %9s %9s %9s\n",
+                     opName(op), static_cast<unsigned long long>(h.count()), formatNs(h.mean()).c_str(),
+                     formatNs(h.percentile(0.50)).c_str(), formatNs(h.percentile(0.99)).c_str(),
+                     formatNs(h.percentile(0.999)).c_str(), formatNs(h.max()).c_str());
+            out += line;
+        }
+        for (int c = 0; c < kCounterCount; ++c) {
+            snprintf(line, sizeof(line), "%s=%llu%s", counterName(c),
+                     static_cast<unsigned long long>(s.counters[c]), c + 1 < kCounterCount ? " " : "\n");
+            out += line;
+        }
+        return out;
+    }
+
+    // 一行（文本协议的回应只能一行）：op=count/p50/p99/p999/max ... 计数器
+    inline string formatLine(const Snapshot& s) {
+        string out;
+        char item[160];
+        for (int op = 0; op < kOpCount; ++op) {
+            const LatencyHistogram& h = s.ops[op];
+            if (h.count() == 0) continue;
+            snprintf(item, sizeof(item), "%s=%llu/%s/%s/%s/%s | ", opName(op),
+                     static_cast<unsigned long long>(h.count()), formatNs(h.percentile(0.50)).c_str(),
+                     formatNs(h.percentile(0.99)).c_str(), formatNs(h.percentile(0.999)).c_str(),
+                     formatNs(h.max()).c_str());
+            out += item;
+        }
+        for (int c = 0; c < kCounterCount; ++c) {
+            snprintf(item, sizeof(item), "%s=%llu%s", counterName(c),
+                     static_cast<unsigned long long>(s.counters[c]), c + 1 < kCounterCount ? " | " : "");
+            out += item;
+        }
+        return out;
+    }
+
+#ifndef VIP_NO_STATS
+
+    inline constexpr bool enabled() { return true; }
+
+    // 单个线程的计数 只有所属线程写（load + store 不是 RMW）其他线程只读
+    // 不提供构造函数：new ThreadSlot() 值初始化 全部清零
+    struct ThreadSlot {
+        atomic<uint64_t> buckets[kOpCount][LatencyHistogram::kBuckets];
+        atomic<uint64_t> sum[kOpCount];
+        atomic<uint64_t> max[kOpCount];
+        atomic<uint64_t> counters[kCounterCount];
+
+        static void bump(atomic<uint64_t>& a, uint64_t n) {
+            a.store(a.load(memory_order_relaxed) + n, memory_order_relaxed);
+        }
+
+        void record(Op op, uint64_t ns) {
+            bump(buckets[op][LatencyHistogram::bucketOf(ns)], 1);
+            bump(sum[op], ns);
+            if (ns > max[op].load(memory_order_relaxed)) max[op].store(ns, memory_order_relaxed);
+        }
+
+        void mergeInto(Snapshot& s) const {
+            for (int op = 0; op < kOpCount; ++op) {
+                for (unsigned b = 0; b < LatencyHistogram::kBuckets; ++b) {
+                    uint64_t n = buckets[op][b].load(memory_order_relaxed);
+                    if (n) s.ops[op].addBucket(b, n);
+                }
+                s.ops[op].addSum(sum[op].load(memory_order_relaxed), max[op].load(memory_order_relaxed));
+            }
+            for (int c = 0; c < kCounterCount; ++c) s.counters[c] += counters[c].load(memory_order_relaxed);
+        }
+    };
+
+    class Registry {
+    private:
+        mutex                mMutex;
+        vector<ThreadSlot*>  mLive;
+        unique_ptr<Snapshot> mRetired{new Snapshot()};
+
+    public:
+        // 故意不析构：进程退出时其他线程的 thread_local 可能还要 detach
+        static Registry& instance() {
+            static Registry* r = new Registry();
+            return *r;
+        }
+
+        ThreadSlot* attach() {
+            ThreadSlot* slot = new ThreadSlot();
+            lock_guard<mutex> lock(mMutex);
+            mLive.push_back(slot);
+            return slot;
+        }
+
+        void detach(ThreadSlot* slot) {
+            lock_guard<mutex> lock(mMutex);
+            slot->mergeInto(*mRetired);
+            for (size_t i = 0; i < mLive.size(); ++i) {
+                if (mLive[i] == slot) { mLive[i] = mLive.back(); mLive.pop_back(); break; }
+            }
+            delete slot;
+        }
+
+        unique_ptr<Snapshot> snapshot() {
+            unique_ptr<Snapshot> s(new Snapshot()); // 直方图数组较大 放堆上
+            lock_guard<mutex> lock(mMutex);
+            *s = *mRetired;
+            for (size_t i = 0; i < mLive.size(); ++i) mLive[i]->mergeInto(*s);
+            return s;
+        }
+    };
+
+    inline ThreadSlot& local() {
+        struct Holder {
+            ThreadSlot* slot;
+            Holder() : slot(Registry::instance().attach()) {}
+            ~Holder() { Registry::instance().detach(slot); }
+        };
+        static thread_local Holder holder;
+        return *holder.slot;
+    }
+
+    inline void record(Op op, uint64_t ns) { local().record(op, ns); }
+    inline void add(Counter c, uint64_t n) { ThreadSlot::bump(local().counters[c], n); }
+
+    class ScopedTimer {
+    private:
+        Op mOp;
+        chrono::steady_clock::time_point mStart;
+
+    public:
+        explicit ScopedTimer(Op op) : mOp(op), mStart(chrono::steady_clock::now()) {}
+        ~ScopedTimer() {
+            record(mOp, static_cast<uint64_t>(
+                chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - mStart).count()));
+        }
+    };
+
+    inline string report() { return formatTable(*Registry::instance().snapshot()); }
+    inline string reportLine() { return formatLine(*Registry::instance().snapshot()); }
+
+#define VIP_STATS_CONCAT_(a, b) a##b
+#define VIP_STATS_CONCAT(a, b) VIP_STATS_CONCAT_(a, b)
+#define VIP_STATS_TIMER(op) ::stats::ScopedTimer VIP_STATS_CONCAT(vipStatsTimer_, __LINE__)(op)
+#define VIP_STATS_ADD(counter, n) ::stats::add(counter, static_cast<uint64_t>(n))
+#define VIP_STATS_RECORD(op, ns) ::stats::record(op, static_cast<uint64_t>(ns))
+
+#else
+
+    inline constexpr bool enabled() { return false; }
+    inline string report() { return "统计未编译（VIP_NO_STATS）\n"; }
+    inline string reportLine() { return "统计未编译（VIP_NO_STATS）"; }
+
+#define VIP_STATS_TIMER(op) do {} while (0)
+#define VIP_STATS_ADD(counter, n) do {} while (0)
+#define VIP_STATS_RECORD(op, ns) do {} while (0)
+
+#endif
+
+    // 定时把统计表追加到文件（--stats-dump）
+    class StatsDumper {
+    private:
+        thread             mThread;
+        mutex              mMutex;
+        condition_variable mWake;
+        bool               mStop = false;
+
+        StatsDumper(const StatsDumper&);
+        StatsDumper& operator=(const StatsDumper&);
+
+        static void dumpTo(const string& path) {
+            FILE* f = fopen(path.c_str(), "a");
+            if (!f) return;
+            char when[32];
+            time_t now = time(nullptr);
+            strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime(&now));
+            string body = report();
+            fprintf(f, "===== %s =====\n%s", when, body.c_str());
+            fclose(f);
+        }
+
+    public:
+        StatsDumper() {}
+        ~StatsDumper() { stop(); }
+
+        void start(const string& path, unsigned seconds) {
+            if (mThread.joinable() || seconds == 0) return;
+            mThread = thread([this, path, seconds]() {
+                unique_lock<mutex> lock(mMutex);
+                while (!mStop) {
+                    if (mWake.wait_for(lock, chrono::seconds(seconds), [this]() { return mStop; })) break;
+                    dumpTo(path);
+                }
+                dumpTo(path); // 退出前最后一份
+            });
+        }
+
+        void stop() {
+            {
+                lock_guard<mutex> lock(mMutex);
+                mStop = true;
+            }
+            mWake.notify_one();
+            if (mThread.joinable()) mThread.join();
+        }
+    };
+
+}
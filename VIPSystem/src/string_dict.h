@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+using namespace std;
+
+/*
+ * 字符串字典（interning）：字符串 <-> 稠密 32 位编号
+ * - 同一个字符串只存一份 编号从 0 开始连续分配 永不回收
+ * - 用 deque 存字符串：扩容不搬家 哈希表里的 string_view key 一直有效
+ * - 不加锁 多线程加载时每个线程用自己的字典 最后用 remapInto 合并
+ */
+
+class StringDict {
+private:
+    deque<string>                         mStrings;
+    unordered_map<string_view, uint32_t>  mCodes;
+
+public:
+    static constexpr uint32_t kNone = 0xFFFFFFFFu;
+
+    size_t size() const { return mStrings.size(); }
+
+    uint32_t intern(string_view s) {
+        auto it = mCodes.find(s);
+        if (it != mCodes.end()) return it->second;
+
+        uint32_t code = static_cast<uint32_t>(mStrings.size());
+        mStrings.emplace_back(s);
+        mCodes.emplace(string_view(mStrings.back()), code);
+        return code;
+    }
+
+    // 不存在返回 kNone
+    uint32_t find(string_view s) const {
+        auto it = mCodes.find(s);
+        return it == mCodes.end() ? kNone : it->second;
+    }
+
+    const string& str(uint32_t code) const { return mStrings[code]; }
+
+    // 把 local 的每个编号映射到本字典的编号（local 里第 i 个字符串 -> 返回值[i]）
+    vector<uint32_t> remapInto(const StringDict& local) {
+        vector<uint32_t> remap(local.size());
+        for (size_t i = 0; i < local.size(); ++i) remap[i] = intern(local.mStrings[i]);
+        return remap;
+    }
+
+    void clear() {
+        mCodes.clear();
+        mStrings.clear();
+    }
+};
@@ -2,40 +2,73 @@
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <charconv>
+#include <cstdint>
+
+#include "money.h"
+#include "string_dict.h"
 
 using namespace std;
 
 /*
  * 消费记录 文件存储 + 查询展示
  * - dateKey：yyyymmdd 
+ * - amount / pay：Money 定点数（分）
+ * - memberHandle：会员号在会员号字典里的编号（4 字节 不再每条交易存一份字符串）
+ * - itemCode：商品/备注在商品字典里的编号（"未填写"、SKU 名这些高度重复的文本只存一份）
+ * - 写文件时用 TransactionDicts 换回字符串 文本格式不变
  */
 
+// 交易用到的两个字典 一起传递
+struct TransactionDicts {
+    StringDict memberIds;
+    StringDict items;
+
+    void clear() {
+        memberIds.clear();
+        items.clear();
+    }
+};
+
 class Transaction {
 public:
     long   transactionId;
-    string memberId;
+    uint32_t memberHandle;
     string date;
     int    dateKey;
-    string item;
-    double amount;
-    double pay;
+    uint32_t itemCode;
+    Money  amount;
+    Money  pay;
     int    pointsEarned;
 
 public:
     Transaction()
-        : transactionId(0), dateKey(0), amount(0.0), pay(0.0), pointsEarned(0) {}
+        : transactionId(0), memberHandle(StringDict::kNone), dateKey(0),
+          itemCode(StringDict::kNone), pointsEarned(0) {}
 
     // transactionId | memberId | date | item | amount | pay | pointsEarned
-    string infoTxt() const {
-        ostringstream oss;
-        oss << transactionId << " | "
-            << memberId << " | "
-            << date << " | "
-            << item << " | "
-            // fixed 固定小数格式 setprecision 保留两位小数
-            << fixed << setprecision(2) << amount << " | "
-            << fixed << setprecision(2) << pay << " | "
-            << pointsEarned;
-        return oss.str();
+    string infoTxt(const TransactionDicts& dicts) const {
+        string out;
+        appendTxt(out, dicts);
+        return out;
+    }
+
+    // 追加到 out 末尾（不经过 ostringstream 批量写日志/快照时用）
+    void appendTxt(string& out, const TransactionDicts& dicts) const {
+        char buf[32];
+        out.append(buf, to_chars(buf, buf + sizeof(buf), transactionId).ptr);
+        out += " | ";
+        out += dicts.memberIds.str(memberHandle);
+        out += " | ";
+        out += date;
+        out += " | ";
+        out += dicts.items.str(itemCode);
+        out += " | ";
+        // Money 自带两位小数格式
+        out.append(buf, amount.format(buf));
+        out += " | ";
+        out.append(buf, pay.format(buf));
+        out += " | ";
+        out.append(buf, to_chars(buf, buf + sizeof(buf), pointsEarned).ptr);
     }
 };
@@ -0,0 +1,139 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "transaction.h"
+#include "string_dict.h"
+
+using namespace std;
+
+/*
+ * 交易表（内存层）：按列存 每个字段一个连续数组 这就是交易本身 没有另一份 vector<Transaction>
+ * - 扫描只读用到的列：区间合计只碰 dateKey + 金额 + 积分 约 28 字节/行（内核见 column_scan.h）
+ * - 一行 = 7 个数值列 + 日期原文编号 共 44 字节；原来的 Transaction 一条约 80 字节（带一个 date 字符串）
+ * - date 字符串不存：和 dateKey 的标准写法（YYYY-MM-DD / dateKey 为 0 时空串）一致的行 读的时候现拼
+ *   不一致的（非法日期原文）放进 dateTexts 这一列记编号 和二进制快照的日期例外一样
+ * - 需要 const Transaction& 的地方（明细回调 / 写文件 / 日志）用 load 临时拼一条
+ *   只要数值的地方（汇总增减）用 loadNumeric 不拼日期
+ * - 第 i 行和 TransactionStore 的 mFlags[i] 对应 压缩时 moveRow 前移
+ */
+
+struct TransactionColumns {
+    vector<int64_t>  transactionId;
+    vector<uint32_t> memberHandle;
+    vector<int32_t>  dateKey;
+    vector<uint32_t> itemCode;
+    vector<int64_t>  amountCents;
+    vector<int64_t>  payCents;
+    vector<int32_t>  points;
+    vector<uint32_t> dateText;    // StringDict::kNone = 标准写法 否则是 dateTexts 的编号
+    StringDict       dateTexts;
+
+    // date 是不是 dateKey 的标准写法（和 util::intToDate 一致）
+    static bool canonicalDate(const string& date, int key) {
+        if (key <= 0) return date.empty();
+        char buf[10];
+        formatDate(key, buf);
+        return date.size() == 10 && date.compare(0, 10, buf, 10) == 0;
+    }
+
+    // yyyymmdd -> "YYYY-MM-DD"（10 个字符 不带结尾 0）
+    static void formatDate(int key, char* out) {
+        int y = key / 10000 % 10000, m = key / 100 % 100, d = key % 100;
+        out[0] = static_cast<char>('0' + y / 1000);
+        out[1] = static_cast<char>('0' + y / 100 % 10);
+        out[2] = static_cast<char>('0' + y / 10 % 10);
+        out[3] = static_cast<char>('0' + y % 10);
+        out[4] = '-';
+        out[5] = static_cast<char>('0' + m / 10);
+        out[6] = static_cast<char>('0' + m % 10);
+        out[7] = '-';
+        out[8] = static_cast<char>('0' + d / 10);
+        out[9] = static_cast<char>('0' + d % 10);
+    }
+
+    size_t size() const { return dateKey.size(); }
+
+    void clear() {
+        transactionId.clear();
+        memberHandle.clear();
+        dateKey.clear();
+        itemCode.clear();
+        amountCents.clear();
+        payCents.clear();
+        points.clear();
+        dateText.clear();
+        dateTexts.clear();
+    }
+
+    void reserve(size_t n) {
+        transactionId.reserve(n);
+        memberHandle.reserve(n);
+        dateKey.reserve(n);
+        itemCode.reserve(n);
+        amountCents.reserve(n);
+        payCents.reserve(n);
+        points.reserve(n);
+        dateText.reserve(n);
+    }
+
+    void push(const Transaction& t) {
+        transactionId.push_back(t.transactionId);
+        memberHandle.push_back(t.memberHandle);
+        dateKey.push_back(t.dateKey);
+        itemCode.push_back(t.itemCode);
+        amountCents.push_back(t.amount.cents());
+        payCents.push_back(t.pay.cents());
+        points.push_back(t.pointsEarned);
+        dateText.push_back(canonicalDate(t.date, t.dateKey) ? StringDict::kNone : dateTexts.intern(t.date));
+    }
+
+    // 第 pos 行拼成 Transaction（date 字符串 10 个字符 走短字符串优化 不分配）
+    void load(size_t pos, Transaction& t) const {
+        loadNumeric(pos, t);
+        if (dateText[pos] != StringDict::kNone) {
+            t.date = dateTexts.str(dateText[pos]);
+        } else if (t.dateKey <= 0) {
+            t.date.clear();
+        } else {
+            char buf[10];
+            formatDate(t.dateKey, buf);
+            t.date.assign(buf, 10);
+        }
+    }
+
+    // 只填数值字段 date 不动（汇总增减用）
+    void loadNumeric(size_t pos, Transaction& t) const {
+        t.transactionId = static_cast<long>(transactionId[pos]);
+        t.memberHandle = memberHandle[pos];
+        t.dateKey = dateKey[pos];
+        t.itemCode = itemCode[pos];
+        t.amount = Money::fromCents(amountCents[pos]);
+        t.pay = Money::fromCents(payCents[pos]);
+        t.pointsEarned = points[pos];
+    }
+
+    // 压缩：第 from 行搬到 to（to < from）
+    void moveRow(size_t from, size_t to) {
+        transactionId[to] = transactionId[from];
+        memberHandle[to] = memberHandle[from];
+        dateKey[to] = dateKey[from];
+        itemCode[to] = itemCode[from];
+        amountCents[to] = amountCents[from];
+        payCents[to] = payCents[from];
+        points[to] = points[from];
+        dateText[to] = dateText[from];
+    }
+
+    void resize(size_t n) {
+        transactionId.resize(n);
+        memberHandle.resize(n);
+        dateKey.resize(n);
+        itemCode.resize(n);
+        amountCents.resize(n);
+        payCents.resize(n);
+        points.resize(n);
+        dateText.resize(n);
+    }
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <cstddef>
+#include <cstdint>
+
+#include "transaction.h"
+
+using namespace std;
+
+/*
+ * 会员 -> 交易位置 索引
+ * - 按会员号字典编号（memberHandle）直接下标访问 不再哈希字符串
+ * - 记录的是在交易表（TransactionColumns）里的行号 行由调用方按行号从列里拼
+ * - 新增消费时 push 一个下标；删除会员时 erase 该会员（行只打墓碑）压缩后下标变了 需要 rebuild
+ *
+ * 日期 -> 交易位置 索引（DateIndex）
+ * - 有序 map：dateKey(yyyymmdd) -> 当天的交易下标
+ * - 区间查询 lower_bound/upper_bound 定位 只访问命中的日期桶
+ * - 删除会员不动日期桶 墓碑行由调用方跳过 压缩后 rebuild
+ */
+
+class MemberTransactionIndex {
+private:
+    vector<vector<size_t>> mPositions;   // memberHandle -> 下标列表
+
+public:
+    void clear() { mPositions.clear(); }
+
+    // 新交易追加到 rows 末尾后调用
+    void add(uint32_t memberHandle, size_t pos) {
+        if (memberHandle >= mPositions.size()) mPositions.resize(memberHandle + 1);
+        mPositions[memberHandle].push_back(pos);
+    }
+
+    void erase(uint32_t memberHandle) {
+        if (memberHandle < mPositions.size()) vector<size_t>().swap(mPositions[memberHandle]);
+    }
+
+    // 全量重建：加载完成 / 交易表压缩之后 memberHandle 是交易表的会员列
+    void rebuild(const vector<uint32_t>& memberHandle) {
+        mPositions.clear();
+        for (size_t i = 0; i < memberHandle.size(); ++i) add(memberHandle[i], i);
+    }
+
+    // fn(size_t pos) 该会员每条交易的下标
+    template <typename Fn>
+    void forEachPosition(uint32_t memberHandle, Fn fn) const {
+        if (memberHandle >= mPositions.size()) return;
+        const vector<size_t>& list = mPositions[memberHandle];
+        for (size_t i = 0; i < list.size(); ++i) fn(list[i]);
+    }
+};
+
+class DateIndex {
+private:
+    map<int, vector<size_t>> mBuckets;
+
+public:
+    void clear() { mBuckets.clear(); }
+
+    void add(int dateKey, size_t pos) { mBuckets[dateKey].push_back(pos); }
+
+    // dateKey 是交易表的日期列
+    void rebuild(const vector<int32_t>& dateKey) {
+        mBuckets.clear();
+        for (size_t i = 0; i < dateKey.size(); ++i) mBuckets[dateKey[i]].push_back(i);
+    }
+
+    // [fromKey, toKey] 闭区间 按日期升序回调 fn(size_t pos)
+    template <typename Fn>
+    void forEachBetween(int fromKey, int toKey, Fn fn) const {
+        forEachBucketBetween(fromKey, toKey, [&](int, const vector<size_t>& bucket) {
+            for (size_t i = 0; i < bucket.size(); ++i) fn(bucket[i]);
+        });
+    }
+
+    // [fromKey, toKey] 内的下标数（含墓碑行）O(区间天数) 用来估算命中率
+    size_t countBetween(int fromKey, int toKey) const {
+        size_t n = 0;
+        forEachBucketBetween(fromKey, toKey, [&](int, const vector<size_t>& bucket) { n += bucket.size(); });
+        return n;
+    }
+
+    // 按天回调 fn(int dateKey, const vector<size_t>& positions)（和别的有序来源按日期归并时用）
+    template <typename Fn>
+    void forEachBucketBetween(int fromKey, int toKey, Fn fn) const {
+        if (fromKey > toKey) return;
+        auto it = mBuckets.lower_bound(fromKey);
+        auto end = mBuckets.upper_bound(toKey);
+        for (; it != end; ++it) fn(it->first, it->second);
+    }
+};
@@ -0,0 +1,817 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <utility>
+#include <algorithm>
+#include <unordered_set>
+#include <unordered_map>
+#include <cstdint>
+#include <climits>
+#include <charconv>
+
+#include "transaction.h"
+#include "transaction_columns.h"
+#include "transaction_index.h"
+#include "member_aggregate.h"
+#include "rollup.h"
+#include "mapped_store.h"
+#include "column_scan.h"
+#include "parallel_loader.h"
+#include "utility.h"
+#include "stats.h"
+
+using namespace std;
+
+/*
+ * 交易存储：交易表 + 字典 + 会员索引 + 日期索引 + 会员消费汇总 + 日/月营收汇总
+ * - 原来散在 VipSystem 里的 mTransactions / mDicts / mMemberIndex / mDateIndex 收拢到这里
+ * - 本身不加锁 由 VipService 用读写锁保护（写：append/removeMember/load 读：其余 const 接口）
+ * - 文本解析（transactions.txt / 日志 P 记录）也在这里 和字典在一起
+ *
+ * 删除会员 = 打墓碑：按会员索引把该会员的行标记为已删除 O(该会员的交易数) 和历史总量无关
+ * - 会员索引 / 汇总立即去掉该会员 日期索引里的下标保留 遍历时跳过墓碑行
+ * - 墓碑超过总行数的 1/4（且不少于 kCompactMinDead）时原地压缩：存活行在各列里前移
+ *   再重建两个索引 每次压缩至少回收 1/4 的行 摊到每条被删交易上是 O(1)
+ *
+ * 归档（见 segment.h / archive.h）：封存过的行照常参与查询 只是标记为已归档 writeTxt 不再写它们
+ * 启动时先读段文件（appendArchived）再读 transactions.txt（loadFile 追加）最后 rebuildIndexes
+ *
+ * 二进制快照（见 mapped_store.h）：attachBase 把映射的文件挂成只读底层 上面那些列 / 索引只放之后新增的行
+ * - 底层的行查询时原地读记录 需要回调 const Transaction& 时才临时拼一条（memberHandle / itemCode 最高位
+ *   kBaseHandle 表示文件内编号 memberIdOf / itemOf 会区分）
+ * - 底层不可修改：删除会员只记该会员已删除（会员粒度）它的营收从汇总里减掉
+ * - checkpoint 只写增量文件（<快照>.delta 见 writeDelta）：删掉的快照会员 + 内存层的存活行 和历史总量无关
+ *   启动时 attachBase 之后 loadDelta 把增量重新放回内存层
+ * - 增量超过快照行数的 1/4（且不少于 kCompactMinDead）时合并（needsMerge）：两层合写成新快照 + 空增量 再 rebase
+ *   每次合并至少吸收 1/4 的行 摊到每条新交易上是 O(1)；proc --convert 也会合并
+ *
+ * 列（见 transaction_columns.h / column_scan.h）：内存层的交易就按列存 没有 vector<Transaction>（每行 44 字节）
+ * - 汇总类查询（区间合计 / 商品汇总 / 区间实付排行 / 封存候选 / 最大交易号）只读列 用 SIMD 内核过滤求和
+ * - 区间命中超过内存层的 1/kScanDivisor 时整列顺序扫描 否则仍走日期索引（窄区间不必扫全表）
+ * - 明细回调 / 写文件和快照底层一样：按行号从列里临时拼一条（loadRow）
+ */
+
+struct ItemTotal {
+    size_t count = 0;
+    Money  amount;
+    Money  pay;
+};
+
+class TransactionStore {
+public:
+    static const size_t kCompactMinDead = 4096;
+    static const size_t kScanDivisor = 8;
+    static constexpr size_t kScanBlock = 4096;   // 列扫描每次过滤的行数（行号缓冲区在栈上）
+
+    // 行标志
+    static constexpr uint8_t kRowDead = 1;       // 墓碑
+    static constexpr uint8_t kRowArchived = 2;   // 已封存到段文件
+
+    // memberHandle / itemCode 最高位：二进制快照里的编号
+    static constexpr uint32_t kBaseHandle = 0x80000000u;
+
+private:
+    TransactionColumns     mColumns;     // 内存层的交易表
+    vector<uint8_t>        mFlags;       // 与 mColumns 的行一一对应
+    size_t                 mDeadCount = 0;
+    size_t                 mArchivedCount = 0;   // 含已删除的
+    TransactionDicts       mDicts;
+    MemberTransactionIndex mMemberIndex;
+    DateIndex              mDateIndex;
+    MemberAggregates       mAggregates;
+    RevenueRollup          mRollup;
+    MappedTransactions     mBase;          // 二进制快照 没有挂时为空
+    vector<uint8_t>        mBaseDeleted;   // 快照会员编号 -> 删除时的等级 + 1（0 = 未删除 第一次删除时才分配）
+    size_t                 mBaseDeadRows = 0;
+
+    bool baseDeleted(uint32_t m) const { return m < mBaseDeleted.size() && mBaseDeleted[m]; }
+
+    // 底层第 pos 行拼成 Transaction（只在回调 / 写文件时用 字段都是拷贝）
+    void loadBaseRow(size_t pos, Transaction& t) const {
+        const mapped::Record& r = mBase.record(pos);
+        t.transactionId = static_cast<long>(r.transactionId);
+        t.memberHandle = kBaseHandle | r.member;
+        t.dateKey = r.dateKey;
+        if (r.dateText == mapped::kNone) t.date = util::intToDate(r.dateKey);
+        else t.date.assign(mBase.dateText(r.dateText));
+        t.itemCode = kBaseHandle | r.item;
+        t.amount = Money::fromCents(r.amountCents);
+        t.pay = Money::fromCents(r.payCents);
+        t.pointsEarned = r.points;
+    }
+
+    uint32_t baseMember(string_view memberId) const {
+        const uint32_t m = mBase.findMember(memberId);
+        return (m == mapped::kNone || baseDeleted(m)) ? mapped::kNone : m;
+    }
+
+    void adoptBase(MappedTransactions& next) {
+        mBase.swap(next);
+        mBase.forEachRollupCell([&](int dateKey, int level, const RollupCell& c) { mRollup.addCell(dateKey, level, c); });
+    }
+
+    // 内存层 [fromKey, toKey] 里非墓碑行的下标 fn(size_t pos)（顺序不保证按日期 只给汇总用）
+    // 命中多时分块列扫描：SIMD 过滤出行号 否则按日期桶取下标
+    template <typename Fn>
+    void forEachDeltaBetween(int fromKey, int toKey, Fn fn) const {
+        if (fromKey > toKey || mColumns.size() == 0) return;
+        const bool wholeTable = fromKey == INT_MIN && toKey == INT_MAX;
+        if (!wholeTable && mDateIndex.countBetween(fromKey, toKey) * kScanDivisor < mColumns.size()) {
+            size_t scanned = 0;
+            mDateIndex.forEachBetween(fromKey, toKey, [&](size_t pos) {
+                ++scanned;
+                if (!(mFlags[pos] & kRowDead)) fn(pos);
+            });
+            VIP_STATS_ADD(stats::kRowsScanned, scanned);
+            return;
+        }
+        uint32_t hits[kScanBlock];
+        for (size_t b = 0; b < mColumns.size(); b += kScanBlock) {
+            const size_t len = min(kScanBlock, mColumns.size() - b);
+            const size_t n = simd::selectBetween(mColumns.dateKey.data() + b, mFlags.data() + b, kRowDead, len,
+                                                 fromKey, toKey, hits);
+            for (size_t i = 0; i < n; ++i) fn(b + hits[i]);
+        }
+        VIP_STATS_ADD(stats::kRowsScanned, mColumns.size());
+    }
+
+public:
+    // 内存层第 pos 行拼成 Transaction（含墓碑行 遍历时用 isDead 过滤）
+    void loadRow(size_t pos, Transaction& t) const { mColumns.load(pos, t); }
+    bool isDead(size_t pos) const { return (mFlags[pos] & kRowDead) != 0; }
+    bool isArchived(size_t pos) const { return (mFlags[pos] & kRowArchived) != 0; }
+    const TransactionDicts& dicts() const { return mDicts; }
+    size_t size() const { return mColumns.size() - mDeadCount + mBase.size() - mBaseDeadRows; }
+    size_t deadCount() const { return mDeadCount; }
+    size_t archivedCount() const { return mArchivedCount; }
+
+    void clear() {
+        mColumns.clear();
+        mFlags.clear();
+        mDeadCount = 0;
+        mArchivedCount = 0;
+        mMemberIndex.clear();
+        mDateIndex.clear();
+        mAggregates.clear();
+        mRollup.clear();
+        mBase.close();
+        mBaseDeleted.clear();
+        mBaseDeadRows = 0;
+    }
+
+    uint32_t internMember(string_view id) { return mDicts.memberIds.intern(id); }
+    uint32_t internItem(string_view item) { return mDicts.items.intern(item); }
+
+    string_view memberIdOf(uint32_t handle) const {
+        if (handle & kBaseHandle) return mBase.memberId(handle & ~kBaseHandle);
+        return mDicts.memberIds.str(handle);
+    }
+    string_view memberIdOf(const Transaction& t) const { return memberIdOf(t.memberHandle); }
+    string_view itemOf(const Transaction& t) const {
+        if (t.itemCode & kBaseHandle) return mBase.item(t.itemCode & ~kBaseHandle);
+        return mDicts.items.str(t.itemCode);
+    }
+
+    // levelCode：消费会员的等级（营收汇总按等级分）
+    void append(const Transaction& t, int levelCode) {
+        mColumns.push(t);
+        mFlags.push_back(0);
+        mMemberIndex.add(t.memberHandle, mColumns.size() - 1);
+        mDateIndex.add(t.dateKey, mColumns.size() - 1);
+        mAggregates.add(t);
+        mRollup.add(t, levelCode);
+    }
+
+    // 删除会员的全部交易（打墓碑）返回删除条数
+    // 会员号编号保留在字典里（同一个号以后再注册还是同一个编号）
+    size_t removeMember(string_view memberId, int levelCode) {
+        size_t removed = 0;
+        const uint32_t m = baseMember(memberId);
+        if (m != mapped::kNone) {
+            Transaction t;
+            mBase.forEachMemberRow(m, [&](size_t pos) {
+                loadBaseRow(pos, t);
+                mRollup.remove(t, levelCode);
+                ++removed;
+            });
+            if (mBaseDeleted.empty()) mBaseDeleted.resize(mBase.memberCount(), 0);
+            mBaseDeleted[m] = static_cast<uint8_t>(levelCode + 1);   // 写增量时要带上 重新加载时按同样的等级扣汇总
+            mBaseDeadRows += removed;
+            VIP_STATS_ADD(stats::kRowsScanned, removed);
+        }
+
+        const uint32_t handle = mDicts.memberIds.find(memberId);
+        if (handle == StringDict::kNone) return removed;
+
+        const size_t baseRemoved = removed;
+        Transaction t;   // 汇总只用数值字段
+        mMemberIndex.forEachPosition(handle, [&](size_t pos) {
+            mColumns.loadNumeric(pos, t);
+            mRollup.remove(t, levelCode);
+            mFlags[pos] |= kRowDead;
+            ++removed;
+        });
+        VIP_STATS_ADD(stats::kRowsScanned, removed - baseRemoved);
+        mDeadCount += removed - baseRemoved;
+
+        mMemberIndex.erase(handle);
+        mAggregates.erase(handle);
+
+        if (mDeadCount >= kCompactMinDead && mDeadCount * 4 >= mColumns.size()) compact();
+        return removed;
+    }
+
+    // 原地去掉墓碑行 存活行保持原顺序 下标变了 两个索引重建
+    void compact() {
+        if (mDeadCount == 0) return;
+        VIP_STATS_ADD(stats::kRowsScanned, mColumns.size());
+        size_t w = 0;
+        mArchivedCount = 0;
+        for (size_t i = 0; i < mColumns.size(); ++i) {
+            if (mFlags[i] & kRowDead) continue;
+            if (w != i) {
+                mColumns.moveRow(i, w);
+                mFlags[w] = mFlags[i];
+            }
+            if (mFlags[w] & kRowArchived) ++mArchivedCount;
+            ++w;
+        }
+        mColumns.resize(w);
+        mFlags.resize(w);
+        mDeadCount = 0;
+        mMemberIndex.rebuild(mColumns.memberHandle);
+        mDateIndex.rebuild(mColumns.dateKey);
+    }
+
+    void rebuildIndexes() {
+        mMemberIndex.rebuild(mColumns.memberHandle);
+        mDateIndex.rebuild(mColumns.dateKey);
+        mAggregates.rebuild(mColumns);
+    }
+
+    // 营收汇总全量重建（加载后）levelOf[memberHandle] = 等级
+    // 日志重放里的删除会留下墓碑 先压缩 归约时就不用逐行判断
+    void rebuildRollup(const vector<int>& levelOf, unsigned threads) {
+        compact();
+        mRollup.rebuild(mColumns, levelOf, threads);
+    }
+
+    const RevenueRollup& rollup() const { return mRollup; }
+
+    // ================== 二进制快照 ==================
+
+    // 挂上二进制快照作为底层（调用前先 clear）只校验文件头 日营收汇总直接并入
+    bool attachBase(const string& path, string* err = nullptr) {
+        MappedTransactions next;
+        if (!next.open(path, err)) return false;
+        adoptBase(next);
+        return true;
+    }
+
+    // 合并写完新快照后：换成新文件的映射 内存层清空（新文件已经包含全部有效行）
+    // 打不开新文件时什么都不变
+    bool rebase(const string& path, string* err = nullptr) {
+        MappedTransactions next;
+        if (!next.open(path, err)) return false;
+        clear();
+        adoptBase(next);
+        return true;
+    }
+
+    bool hasBase() const { return mBase.isOpen(); }
+    const MappedTransactions& base() const { return mBase; }
+
+    // 增量该合并进快照了（没挂快照时内存层就是全部 也算）
+    bool needsMerge() const {
+        const size_t delta = mColumns.size() + mBaseDeadRows;
+        return !mBase.isOpen() || (delta >= kCompactMinDead && delta * 4 >= mBase.size());
+    }
+
+    // 增量文件（每行一条 和日志一样 "标记 | 字段"）
+    //   B | 快照文件头校验和 | 下一个交易号     第一行 认准它叠在哪个快照上
+    //   D | 会员号 | 等级                      快照里这个会员的行都已删除
+    //   P | 交易文本（字段同 parseLine）       内存层的存活行 按原顺序
+    static string deltaHeader(uint64_t baseChecksum, long nextTransactionId) {
+        return "B | " + to_string(baseChecksum) + " | " + to_string(nextTransactionId) + "\n";
+    }
+
+    template <typename Stream>
+    void writeDelta(Stream& out, long nextTransactionId) const {
+        string buf = deltaHeader(mBase.checksum(), nextTransactionId);
+        out << buf;
+        for (size_t m = 0; m < mBaseDeleted.size(); ++m) {
+            if (!mBaseDeleted[m]) continue;
+            buf = "D | ";
+            buf.append(mBase.memberId(static_cast<uint32_t>(m)));
+            buf += " | " + to_string(mBaseDeleted[m] - 1) + "\n";
+            out << buf;
+        }
+        Transaction t;
+        for (size_t i = 0; i < mColumns.size(); ++i) {
+            if (mFlags[i] & kRowDead) continue;
+            mColumns.load(i, t);
+            buf = "P | ";
+            t.appendTxt(buf, mDicts);
+            buf += '\n';
+            out << buf;
+        }
+    }
+
+    // attachBase 之后调用：增量放回内存层 nextTransactionId 带回增量记的交易号水位线
+    // 文件不存在 = 没有增量；和当前快照对不上（校验和不同）返回 false：不能把别的快照的增量叠上来
+    // levelOf(memberId) -> 等级（增量行按会员当前等级进营收汇总）
+    template <typename LevelOf>
+    bool loadDelta(const string& path, LevelOf levelOf, long* nextTransactionId, string* err = nullptr) {
+        string data;
+        if (!loader::readWholeFile(path, data)) return true;
+        VIP_STATS_ADD(stats::kBytesRead, data.size());
+
+        bool matched = false;
+        loader::forEachLine(data.data(), data.data() + data.size(), [&](const char* b, const char* e) {
+            string_view line = util::trimView(string_view(b, static_cast<size_t>(e - b)));
+            if (line.size() < 4 || line[1] != ' ' || line[2] != '|') return;
+            string_view body = line.substr(4);
+            if (line[0] == 'B') {
+                array<string_view, 2> f;
+                uint64_t checksum = 0;
+                matched = util::splitFields(body, f) &&
+                          from_chars(f[0].data(), f[0].data() + f[0].size(), checksum).ec == errc() &&
+                          checksum == mBase.checksum();
+                if (matched) *nextTransactionId = util::parseLong(f[1]);
+                return;
+            }
+            if (!matched) return;
+            if (line[0] == 'D') {
+                array<string_view, 2> f;
+                if (util::splitFields(body, f)) removeMember(f[0], util::parseInt(f[1]));
+            } else if (line[0] == 'P') {
+                Transaction t;
+                if (parseLine(body, t)) append(t, levelOf(memberIdOf(t)));
+            }
+        });
+        if (!matched && err) *err = "增量文件和快照对不上";
+        return matched;
+    }
+
+    // 全部有效行（快照里未删除的 + 内存里非墓碑的 含已归档的）写成二进制快照 返回字节数 失败返回 0
+    // levelOf(memberId) -> 等级（每个会员问一次）checksum 带回新文件的文件头校验和
+    template <typename LevelOf>
+    size_t writeBinary(const string& path, long nextTransactionId, LevelOf levelOf, uint64_t* checksum = nullptr) const {
+        mapped::Writer w;
+        Transaction t;
+        for (size_t pos = 0; pos < mBase.size(); ++pos) {
+            const mapped::Record& r = mBase.record(pos);
+            if (baseDeleted(r.member)) continue;
+            loadBaseRow(pos, t);
+            w.add(t, mBase.memberId(r.member), mBase.item(r.item), levelOf);
+        }
+        for (size_t i = 0; i < mColumns.size(); ++i) {
+            if (mFlags[i] & kRowDead) continue;
+            mColumns.load(i, t);
+            w.add(t, mDicts.memberIds.str(t.memberHandle), mDicts.items.str(t.itemCode), levelOf);
+        }
+        VIP_STATS_ADD(stats::kRowsScanned, mBase.size() + mColumns.size());
+        return w.write(path, nextTransactionId, checksum);
+    }
+
+    // ================== 归档 ==================
+
+    // 段文件读出的行（编号是段内字典的）并入 标记为已归档 交易号 < watermarkOf(memberId) 的丢弃（已删除会员）
+    // watermarkOf 按段内字典每个会员号问一次
+    // 只在加载阶段用 索引由最后的 rebuildIndexes 统一建
+    template <typename WatermarkOf>
+    size_t appendArchived(vector<Transaction>& rows, const TransactionDicts& dicts, WatermarkOf watermarkOf) {
+        vector<uint32_t> memberRemap = mDicts.memberIds.remapInto(dicts.memberIds);
+        vector<uint32_t> itemRemap = mDicts.items.remapInto(dicts.items);
+        vector<long> watermark(dicts.memberIds.size());
+        for (uint32_t h = 0; h < watermark.size(); ++h) watermark[h] = watermarkOf(dicts.memberIds.str(h));
+        size_t kept = 0;
+        mColumns.reserve(mColumns.size() + rows.size());
+        for (size_t i = 0; i < rows.size(); ++i) {
+            Transaction& t = rows[i];
+            if (t.transactionId < watermark[t.memberHandle]) continue;
+            t.memberHandle = memberRemap[t.memberHandle];
+            t.itemCode = itemRemap[t.itemCode];
+            mColumns.push(t);
+            mFlags.push_back(kRowArchived);
+            ++kept;
+        }
+        mArchivedCount += kept;
+        return kept;
+    }
+
+    // 待封存：未归档 未删除 且日期早于 beforeKey 的行 按存储顺序
+    vector<size_t> sealCandidates(int beforeKey) const {
+        vector<size_t> out;
+        if (beforeKey == INT_MIN) return out;
+        uint32_t hits[kScanBlock];
+        for (size_t b = 0; b < mColumns.size(); b += kScanBlock) {
+            const size_t len = min(kScanBlock, mColumns.size() - b);
+            const size_t n = simd::selectBetween(mColumns.dateKey.data() + b, mFlags.data() + b, 0xFF, len,
+                                                 INT_MIN, beforeKey - 1, hits);
+            for (size_t i = 0; i < n; ++i) out.push_back(b + hits[i]);
+        }
+        VIP_STATS_ADD(stats::kRowsScanned, mColumns.size());
+        return out;
+    }
+
+    void markArchived(const vector<size_t>& positions) {
+        for (size_t i = 0; i < positions.size(); ++i) mFlags[positions[i]] |= kRowArchived;
+        mArchivedCount += positions.size();
+    }
+
+    long maxTransactionId() const {
+        return static_cast<long>(simd::maxOf(mColumns.transactionId.data(), mFlags.data(), kRowDead, mColumns.size(),
+                                             mBase.nextTransactionId() - 1));
+    }
+
+    // ================== 查询 ==================
+
+    // 某会员的消费汇总 O(1) 不扫交易（快照里的汇总 + 内存里新增的）
+    MemberAggregate aggregate(string_view memberId) const {
+        MemberAggregate agg;
+        const uint32_t m = baseMember(memberId);
+        if (m != mapped::kNone) agg = mBase.summary(m);
+        uint32_t handle = mDicts.memberIds.find(memberId);
+        if (handle != StringDict::kNone) agg.merge(mAggregates.get(handle));
+        return agg;
+    }
+
+    // 某会员的全部交易 先快照里的再内存里的（各自按录入顺序）fn(const Transaction&) 返回条数
+    template <typename Fn>
+    size_t forEachMemberTransaction(string_view memberId, Fn fn) const {
+        size_t n = 0;
+        const uint32_t m = baseMember(memberId);
+        if (m != mapped::kNone) {
+            Transaction t;
+            mBase.forEachMemberRow(m, [&](size_t pos) {
+                loadBaseRow(pos, t);
+                fn(static_cast<const Transaction&>(t));
+                ++n;
+            });
+        }
+        const uint32_t handle = mDicts.memberIds.find(memberId);
+        if (handle != StringDict::kNone) {
+            Transaction t;
+            mMemberIndex.forEachPosition(handle, [&](size_t pos) {
+                mColumns.load(pos, t);
+                fn(static_cast<const Transaction&>(t));
+                ++n;
+            });
+        }
+        VIP_STATS_ADD(stats::kRowsScanned, n);
+        return n;
+    }
+
+    // [fromKey, toKey] 日期区间内的交易 按日期升序回调 fn(const Transaction&) 返回条数
+    // 同一天快照里的行在前 memberId 非空时只看该会员：直接用会员索引（通常比日期桶小得多）
+    template <typename Fn>
+    size_t forEachBetween(int fromKey, int toKey, string_view memberId, Fn fn) const {
+        if (fromKey > toKey) return 0;
+        Transaction scratch;
+        size_t scanned = 0;
+
+        if (!memberId.empty()) {
+            // 两层都只记行号 按日期稳定排序后再逐条拼出来回调
+            struct Hit {
+                int    dateKey;
+                size_t pos;
+                bool   base;   // true = 快照第 pos 行 否则内存层第 pos 行
+            };
+            vector<Hit> hits;
+            const uint32_t m = baseMember(memberId);
+            if (m != mapped::kNone) {
+                mBase.forEachMemberRow(m, [&](size_t pos) {
+                    ++scanned;
+                    const int key = mBase.record(pos).dateKey;
+                    if (key >= fromKey && key <= toKey) hits.push_back(Hit{ key, pos, true });
+                });
+            }
+            const uint32_t handle = mDicts.memberIds.find(memberId);
+            if (handle != StringDict::kNone) {
+                mMemberIndex.forEachPosition(handle, [&](size_t pos) {
+                    ++scanned;
+                    const int key = mColumns.dateKey[pos];
+                    if (key >= fromKey && key <= toKey) hits.push_back(Hit{ key, pos, false });
+                });
+            }
+            VIP_STATS_ADD(stats::kRowsScanned, scanned);
+            stable_sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) { return a.dateKey < b.dateKey; });
+            for (size_t i = 0; i < hits.size(); ++i) {
+                if (hits[i].base) loadBaseRow(hits[i].pos, scratch);
+                else mColumns.load(hits[i].pos, scratch);
+                fn(static_cast<const Transaction&>(scratch));
+            }
+            return hits.size();
+        }
+
+        // 两层各自按日期有序 按天归并
+        size_t n = 0;
+        size_t day = mBase.dayLowerBound(fromKey);
+        auto baseUpTo = [&](int lastKey) {
+            for (; day < mBase.dayCount() && mBase.dayKey(day) <= lastKey; ++day) {
+                mBase.forEachRowOfDay(day, [&](size_t pos) {
+                    ++scanned;
+                    if (baseDeleted(mBase.record(pos).member)) return;
+                    loadBaseRow(pos, scratch);
+                    fn(static_cast<const Transaction&>(scratch));
+                    ++n;
+                });
+            }
+        };
+        mDateIndex.forEachBucketBetween(fromKey, toKey, [&](int dateKey, const vector<size_t>& bucket) {
+            baseUpTo(dateKey);
+            for (size_t i = 0; i < bucket.size(); ++i) {
+                ++scanned;
+                if (mFlags[bucket[i]] & kRowDead) continue;
+                mColumns.load(bucket[i], scratch);
+                fn(static_cast<const Transaction&>(scratch));
+                ++n;
+            }
+        });
+        baseUpTo(toKey);
+        VIP_STATS_ADD(stats::kRowsScanned, scanned);
+        return n;
+    }
+
+    // [fromKey, toKey] 全部会员的 笔数 / 原价 / 实付 / 积分合计 + 最早 / 最晚 dateKey
+    // 内存层命中多时直接在列上 SIMD 求和（不取下标 不拼行）快照层按日期范围读记录
+    simd::RangeTotals rangeTotals(int fromKey, int toKey) const {
+        simd::RangeTotals t;
+        if (fromKey > toKey) return t;
+        size_t scanned = 0;
+        mBase.forEachBetween(fromKey, toKey, [&](size_t pos) {
+            ++scanned;
+            const mapped::Record& r = mBase.record(pos);
+            if (baseDeleted(r.member)) return;
+            ++t.count;
+            t.amountCents += r.amountCents;
+            t.payCents += r.payCents;
+            t.points += r.points;
+            if (r.dateKey < t.minKey) t.minKey = r.dateKey;
+            if (r.dateKey > t.maxKey) t.maxKey = r.dateKey;
+        });
+        VIP_STATS_ADD(stats::kRowsScanned, scanned);
+
+        if (mDateIndex.countBetween(fromKey, toKey) * kScanDivisor >= mColumns.size()) {
+            t.merge(simd::sumBetween(mColumns.dateKey.data(), mFlags.data(), kRowDead, mColumns.amountCents.data(),
+                                     mColumns.payCents.data(), mColumns.points.data(), mColumns.size(), fromKey, toKey));
+            VIP_STATS_ADD(stats::kRowsScanned, mColumns.size());
+            return t;
+        }
+        scanned = 0;
+        mDateIndex.forEachBetween(fromKey, toKey, [&](size_t pos) {
+            ++scanned;
+            if (mFlags[pos] & kRowDead) return;
+            const int key = mColumns.dateKey[pos];
+            ++t.count;
+            t.amountCents += mColumns.amountCents[pos];
+            t.payCents += mColumns.payCents[pos];
+            t.points += mColumns.points[pos];
+            if (key < t.minKey) t.minKey = key;
+            if (key > t.maxKey) t.maxKey = key;
+        });
+        VIP_STATS_ADD(stats::kRowsScanned, scanned);
+        return t;
+    }
+
+    // 按商品分组汇总 只返回有消费的商品 (商品名, 汇总)
+    // 分组只是数组累加：内存层下标是商品编号（读列）快照层下标是文件内商品编号（直接读记录）最后按名字合并
+    // fromKey == 0 表示不限日期
+    vector<pair<string, ItemTotal>> itemTotals(int fromKey, int toKey) const {
+        auto add = [](ItemTotal& it, Money amount, Money pay) {
+            ++it.count;
+            it.amount += amount;
+            it.pay += pay;
+        };
+
+        size_t scanned = 0;
+        vector<ItemTotal> baseTotals(mBase.itemCount());
+        auto addBase = [&](size_t pos) {
+            const mapped::Record& r = mBase.record(pos);
+            if (baseDeleted(r.member) || r.item >= baseTotals.size()) return;
+            add(baseTotals[r.item], Money::fromCents(r.amountCents), Money::fromCents(r.payCents));
+        };
+        if (fromKey == 0) {
+            for (size_t i = 0; i < mBase.size(); ++i) addBase(i);
+            scanned = mBase.size();
+            fromKey = INT_MIN;
+            toKey = INT_MAX;
+        } else {
+            mBase.forEachBetween(fromKey, toKey, [&](size_t pos) { addBase(pos); ++scanned; });
+        }
+        VIP_STATS_ADD(stats::kRowsScanned, scanned);
+
+        vector<ItemTotal> totals(mDicts.items.size());
+        const uint32_t* itemCode = mColumns.itemCode.data();
+        const int64_t* amount = mColumns.amountCents.data();
+        const int64_t* pay = mColumns.payCents.data();
+        forEachDeltaBetween(fromKey, toKey, [&](size_t pos) {
+            add(totals[itemCode[pos]], Money::fromCents(amount[pos]), Money::fromCents(pay[pos]));
+        });
+
+        vector<pair<string, ItemTotal>> out;
+        unordered_map<string_view, size_t> slotOf;   // 只有挂了快照时才需要按名字合并
+        for (uint32_t c = 0; c < baseTotals.size(); ++c) {
+            if (baseTotals[c].count == 0) continue;
+            slotOf[mBase.item(c)] = out.size();
+            out.push_back(make_pair(string(mBase.item(c)), baseTotals[c]));
+        }
+        for (uint32_t c = 0; c < totals.size(); ++c) {
+            if (totals[c].count == 0) continue;
+            const string& name = mDicts.items.str(c);
+            auto it = slotOf.empty() ? slotOf.end() : slotOf.find(name);
+            if (it == slotOf.end()) {
+                out.push_back(make_pair(name, totals[c]));
+                continue;
+            }
+            ItemTotal& dst = out[it->second].second;
+            dst.count += totals[c].count;
+            dst.amount += totals[c].amount;
+            dst.pay += totals[c].pay;
+        }
+        return out;
+    }
+
+    // 实付最高的 k 个会员 (会员编号, 实付合计) 从高到低 同额按会员号 编号用 memberIdOf 换回会员号
+    // fromKey == 0 表示不限日期：直接用会员汇总 否则走日期索引按会员累加
+    // 同一会员在快照和内存层都有消费时合成一条（算在快照编号上）
+    // 只对前 k 个做 partial_sort 不排整张表
+    vector<pair<uint32_t, Money>> topSpenders(int fromKey, int toKey, size_t k) const {
+        vector<pair<uint32_t, Money>> out;
+        vector<size_t> baseSlot;   // 快照会员编号 -> out 下标
+        if (mBase.isOpen()) baseSlot.assign(mBase.memberCount(), SIZE_MAX);
+        auto addDelta = [&](uint32_t h, Money pay) {
+            if (!baseSlot.empty()) {
+                const uint32_t m = baseMember(mDicts.memberIds.str(h));
+                if (m != mapped::kNone && baseSlot[m] != SIZE_MAX) {
+                    out[baseSlot[m]].second += pay;
+                    return;
+                }
+            }
+            out.push_back(make_pair(h, pay));
+        };
+
+        if (fromKey == 0) {
+            for (uint32_t m = 0; m < mBase.memberCount(); ++m) {
+                if (baseDeleted(m)) continue;
+                MemberAggregate agg = mBase.summary(m);
+                if (agg.count == 0) continue;
+                baseSlot[m] = out.size();
+                out.push_back(make_pair(kBaseHandle | m, agg.pay));
+            }
+            for (uint32_t h = 0; h < mAggregates.size(); ++h) {
+                MemberAggregate agg = mAggregates.get(h);
+                if (agg.count > 0) addDelta(h, agg.pay);
+            }
+        } else {
+            size_t scanned = 0;
+            mBase.forEachBetween(fromKey, toKey, [&](size_t pos) {
+                ++scanned;
+                const mapped::Record& r = mBase.record(pos);
+                if (r.member >= baseSlot.size() || baseDeleted(r.member)) return;
+                if (baseSlot[r.member] == SIZE_MAX) {
+                    baseSlot[r.member] = out.size();
+                    out.push_back(make_pair(kBaseHandle | r.member, Money()));
+                }
+                out[baseSlot[r.member]].second += Money::fromCents(r.payCents);
+            });
+
+            VIP_STATS_ADD(stats::kRowsScanned, scanned);
+
+            vector<Money> spend(mDicts.memberIds.size());
+            vector<uint32_t> seen;
+            vector<char> isSeen(mDicts.memberIds.size(), 0);
+            const uint32_t* member = mColumns.memberHandle.data();
+            const int64_t* pay = mColumns.payCents.data();
+            forEachDeltaBetween(fromKey, toKey, [&](size_t pos) {
+                const uint32_t h = member[pos];
+                spend[h] += Money::fromCents(pay[pos]);
+                if (!isSeen[h]) { isSeen[h] = 1; seen.push_back(h); }
+            });
+            for (size_t i = 0; i < seen.size(); ++i) addDelta(seen[i], spend[seen[i]]);
+        }
+
+        auto higher = [&](const pair<uint32_t, Money>& a, const pair<uint32_t, Money>& b) {
+            if (a.second != b.second) return a.second > b.second;
+            return memberIdOf(a.first) < memberIdOf(b.first);
+        };
+        if (k < out.size()) {
+            partial_sort(out.begin(), out.begin() + k, out.end(), higher);
+            out.resize(k);
+        } else {
+            sort(out.begin(), out.end(), higher);
+        }
+        return out;
+    }
+
+    // ================== 文本读写 ==================
+
+    // transactionId | memberId | date | item | amount | pay | pointsEarned
+    // dicts：会员号/商品编到哪组字典里（并行加载时是线程私有字典）
+    static bool parseLine(string_view line, Transaction& t, TransactionDicts& dicts) {
+        array<string_view, 7> f;
+        if (!util::splitFields(line, f)) return false;
+
+        t.transactionId = util::parseLong(f[0]);
+        t.memberHandle = dicts.memberIds.intern(f[1]);
+        t.date.assign(f[2].data(), f[2].size());
+        t.dateKey = util::dateToInt(f[2]);
+        t.itemCode = dicts.items.intern(f[3]);
+        t.amount = Money::parseLenient(f[4]);
+        t.pay = Money::parseLenient(f[5]);
+        t.pointsEarned = util::parseInt(f[6]);
+        return true;
+    }
+
+    bool parseLine(string_view line, Transaction& t) { return parseLine(line, t, mDicts); }
+
+    void appendTxt(const Transaction& t, string& out) const { t.appendTxt(out, mDicts); }
+
+    // 加载 transactions.txt 追加在现有行（段文件读出的归档行）之后 文件不存在返回 false
+    // 之后由调用方 rebuildIndexes；交易行里没有会员等级 营收汇总由调用方 rebuildRollup
+    // 封存后、checkpoint 前崩溃时文本快照里还留着已封存的行：交易号已在归档里的跳过
+    bool loadFile(const string& path, unsigned threads) {
+        string data;
+        if (!loader::readWholeFile(path, data)) return false;
+        VIP_STATS_ADD(stats::kBytesRead, data.size());
+
+        // 分块并行解析（见 parallel_loader.h）
+        // 每块用自己的字典 不用加锁；合并时把块内编号换成全局编号
+        // 商品文本在这里就只 intern 一次 之后全是整数
+        struct Part {
+            vector<Transaction> rows;
+            TransactionDicts    dicts;
+        };
+        vector<pair<size_t, size_t>> chunks = loader::planChunks(data, threads);
+        vector<Part> parts(chunks.size());
+
+        loader::forEachChunkParallel(data, chunks, [&](size_t c, const char* b, const char* e) {
+            Part& part = parts[c];
+            loader::forEachLine(b, e, [&](const char* lb, const char* le) {
+                string_view line = util::trimView(string_view(lb, static_cast<size_t>(le - lb)));
+                if (line.empty()) return;
+                Transaction t;
+                if (parseLine(line, t, part.dicts)) part.rows.push_back(std::move(t));
+            });
+        }, threads);
+
+        // 归档行的交易号范围 文本行落在范围里才需要查重（正常情况下文本里都是更新的交易）
+        long archivedMin = 0, archivedMax = -1;
+        const vector<int64_t>& ids = mColumns.transactionId;
+        for (size_t i = 0; i < ids.size(); ++i) {
+            if (!(mFlags[i] & kRowArchived)) continue;
+            const long id = static_cast<long>(ids[i]);
+            if (archivedMax < archivedMin) archivedMin = archivedMax = id;
+            if (id < archivedMin) archivedMin = id;
+            if (id > archivedMax) archivedMax = id;
+        }
+        unordered_set<long> archivedIds;
+        auto alreadyArchived = [&](long id) {
+            if (id < archivedMin || id > archivedMax) return false;
+            if (archivedIds.empty()) {
+                for (size_t i = 0; i < ids.size(); ++i) {
+                    if (mFlags[i] & kRowArchived) archivedIds.insert(static_cast<long>(ids[i]));
+                }
+            }
+            return archivedIds.count(id) != 0;
+        };
+
+        // 按块号（文件顺序）合并
+        size_t total = mColumns.size();
+        for (size_t i = 0; i < parts.size(); ++i) total += parts[i].rows.size();
+        mColumns.reserve(total);
+        mFlags.reserve(total);
+        for (size_t i = 0; i < parts.size(); ++i) {
+            vector<uint32_t> memberRemap = mDicts.memberIds.remapInto(parts[i].dicts.memberIds);
+            vector<uint32_t> itemRemap = mDicts.items.remapInto(parts[i].dicts.items);
+            for (size_t j = 0; j < parts[i].rows.size(); ++j) {
+                Transaction& t = parts[i].rows[j];
+                if (alreadyArchived(t.transactionId)) continue;
+                t.memberHandle = memberRemap[t.memberHandle];
+                t.itemCode = itemRemap[t.itemCode];
+                mColumns.push(t);
+                mFlags.push_back(0);
+            }
+            vector<Transaction>().swap(parts[i].rows); // 合并完立刻释放
+        }
+        return true;
+    }
+
+    // 写到 out 每行一条 字段顺序和 parseLine 一致（已归档的行在段文件里 不写）
+    template <typename Stream>
+    void writeTxt(Stream& out) const {
+        string buf;
+        Transaction t;
+        for (size_t i = 0; i < mColumns.size(); ++i) {
+            if (mFlags[i] != 0) continue;   // 墓碑 / 已归档
+            mColumns.load(i, t);
+            buf.clear();
+            t.appendTxt(buf, mDicts);
+            buf += '\n';
+            out << buf;
+        }
+    }
+};
@@ -1,5 +1,7 @@
 #pragma once
 #include <string>
+#include <string_view>
+#include <array>
 #include <vector>
 #include <sstream>
 #include <iostream>
@@ -7,14 +9,18 @@
 #include <cstdlib>
 #include <cstdio>
 
+#include "simd_scan.h"
+#include "money.h"
+
 using namespace std;
 
 /*
  * 工具函数（尽量保持简单）
- * - trim / splitByPipe：文件解析（members.txt / transactions.txt）
- * - dateToInt：把 YYYY-MM-DD -> yyyymmdd（用于存储/比较）
+ * - trim / splitByPipe：通用的字符串版本（会分配内存 保留给交互输入和旧代码）
+ * - trimView / splitFields / parseInt...：加载路径用的零分配版本 返回指向原行缓冲区的 string_view
+ * - dateToInt：把 YYYY-MM-DD -> yyyymmdd（用于存储/比较）intToDate 反过来（展示用）
  * - readLineSafe：getline 安全读取
- * - readIntLine / readDoubleLine / readYesNo：交互输入（回车默认）
+ * - readIntLine / readMoneyLine / readYesNo：交互输入（回车默认 金额不经过 double）
  *
  */
 
@@ -47,16 +53,104 @@ namespace util {
         return parts;
     }
 
+    // ---------- 零分配版本（string_view 指向调用方的行缓冲区） ----------
+
+    // 和 simd_scan.h 的空白类一致
+    inline bool isTrimChar(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    // 长串空白（定宽导出的字段）交给向量化扫描（见 simd_scan.h）不内联 免得把 trimView 撑大
+    __attribute__((noinline, cold))
+    inline string_view trimViewLong(string_view s) {
+        const char* end = s.data() + s.size();
+        const char* b = simd::skipSpace(s.data(), end);
+        const char* e = simd::skipSpaceBack(b, end);
+        return string_view(b, static_cast<size_t>(e - b));
+    }
+
+    // 每头内联看最多 kTrimInline 个字节（"a | b" 这种一两个空格最常见 不值得一次间接调用）
+    // 看满了还是空白 整个交给 trimViewLong
+    const size_t kTrimInline = 8;
+
+    inline string_view trimView(string_view s) {
+        const size_t n = s.size();
+        size_t b = 0;
+        const size_t head = n < kTrimInline ? n : kTrimInline;
+        while (b < head && isTrimChar(s[b])) ++b;
+        if (b == kTrimInline) return trimViewLong(s);
+        size_t e = n;
+        const size_t tail = n - head;
+        while (e > tail && e > b && isTrimChar(s[e - 1])) --e;
+        if (e == tail && e > b) return trimViewLong(s);
+        return s.substr(b, e - b);
+    }
+
+    // 在 line 里从 begin 开始找 '|' 找不到返回 npos（向量化扫描 见 simd_scan.h）
+    inline size_t findPipe(string_view line, size_t begin) {
+        const char* end = line.data() + line.size();
+        const char* hit = simd::findByte(line.data() + begin, end, '|');
+        return hit == end ? string_view::npos : static_cast<size_t>(hit - line.data());
+    }
+
+    // 和 splitByPipe 规则一致（每个字段都 trim）
+    // 只写前 maxFields 个字段 返回值是总字段数（即 splitByPipe(line).size()）
+    inline size_t splitByPipeView(string_view line, string_view* fields, size_t maxFields) {
+        size_t count = 0;
+        size_t begin = 0;
+        while (true) {
+            size_t bar = findPipe(line, begin);
+            size_t end = (bar == string_view::npos) ? line.size() : bar;
+            if (count < maxFields) fields[count] = trimView(line.substr(begin, end - begin));
+            ++count;
+            if (bar == string_view::npos) break;
+            begin = bar + 1;
+        }
+        return count;
+    }
+
+    // 定长版本：会员行 6 个字段 / 交易行 7 个字段
+    // 第 N 个字段之后的内容直接忽略（和 splitByPipe 之后只取前 N 个一样）
+    // 字段不足 N 个返回 false
+    template <size_t N>
+    inline bool splitFields(string_view line, array<string_view, N>& out) {
+        size_t begin = 0;
+        for (size_t i = 0; i < N; ++i) {
+            size_t bar = findPipe(line, begin);
+            if (bar == string_view::npos) {
+                if (i + 1 != N) return false;
+                out[i] = trimView(line.substr(begin));
+                return true;
+            }
+            out[i] = trimView(line.substr(begin, bar - begin));
+            begin = bar + 1;
+        }
+        return true;
+    }
+
+    // 和 atol 一样：跳过前导空白 可选正负号 读到非数字为止 没有数字返回 0
+    inline long parseLong(string_view s) {
+        size_t i = 0;
+        while (i < s.size() && (isTrimChar(s[i]) || s[i] == '\v' || s[i] == '\f')) ++i;
+        bool neg = false;
+        if (i < s.size() && (s[i] == '+' || s[i] == '-')) { neg = (s[i] == '-'); ++i; }
+        long v = 0;
+        for (; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i) v = v * 10 + (s[i] - '0');
+        return neg ? -v : v;
+    }
+
+    inline int parseInt(string_view s) { return static_cast<int>(parseLong(s)); }
+
     // 日期字符->日期数字
     // YYYY-MM-DD -> yyyymmdd
-    inline int dateToInt(const string& date) {
+    inline int dateToInt(string_view date) {
         // date 来自用户输入或文件 可能为空
         if (date.size() != 10) return 0;
         if (date[4] != '-' || date[7] != '-') return 0; 
         // 开始索引 数量
-        int y = atoi(date.substr(0, 4).c_str());
-        int m = atoi(date.substr(5, 2).c_str());
-        int d = atoi(date.substr(8, 2).c_str());
+        int y = parseInt(date.substr(0, 4));
+        int m = parseInt(date.substr(5, 2));
+        int d = parseInt(date.substr(8, 2));
 
         // 范围校验 没有加闰年->todo
         if (m < 1 || m > 12) return 0;
@@ -65,6 +159,14 @@ namespace util {
         return y * 10000 + m * 100 + d;
     }
 
+    // yyyymmdd -> YYYY-MM-DD 0 返回空串
+    inline string intToDate(int key) {
+        if (key <= 0) return string();
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%04d-%02d-%02d", key / 10000 % 10000, key / 100 % 100, key % 100);
+        return string(buf);
+    }
+
     inline string todayDate() {
         // 统一日期输出格式：YYYY-MM-DD
         time_t now = time(nullptr);
@@ -96,8 +198,8 @@ namespace util {
         }
     }
 
-    inline double readDoubleLine(const string& prompt, double defaultValue) {
-        // 整行读取 + 回车默认
+    inline Money readMoneyLine(const string& prompt, Money defaultValue) {
+        // 整行读取 + 回车默认 金额直接解析成分 不经过 double
         while (true) {
             cout << prompt;
             string line;
@@ -105,10 +207,9 @@ namespace util {
             line = trim(line);
             if (line.empty()) return defaultValue;
 
-            istringstream iss(line);
-            double v;
-            if (iss >> v) return v;
-            cout << "输入无效 请输入数字\n";
+            Money v;
+            if (Money::parse(line, v)) return v;
+            cout << "输入无效 请输入金额（最多两位小数）\n";
         }
     }
 
@@ -0,0 +1,314 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <csignal>
+#include <cerrno>
+#include <cstdio>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "vip_service.h"
+
+using namespace std;
+
+/*
+ * 服务端模式：一个常驻进程 收银终端通过本地套接字发命令
+ * - 监听 Unix 域套接字（unix:/path）或本机 TCP 端口（tcp:PORT 只绑 127.0.0.1）
+ * - 单线程 epoll 事件循环 非阻塞套接字
+ * - 协议就是 command.h 的文本命令：一行一条 每条回应一行 OK ... / ERR ...
+ * - 支持流水线：客户端可以连发多条不等回应 同一连接内按顺序执行、按顺序回应
+ *
+ * 背压：一个连接待发送的回应超过 kMaxPendingOut（客户端只发不收）就停止读它、停止执行它的命令
+ *       （去掉 EPOLLIN）回应发走一部分后再恢复 服务端内存不会被一个连接撑爆
+ *
+ * 组提交：一轮 epoll_wait 里读到的所有命令执行完 先 syncJournal（一次 fsync）
+ *         再把这一轮的回应写回去 所以收到 OK 时改动已经落盘（落盘失败时这一轮的回应都换成 ERR）
+ *
+ * SIGINT / SIGTERM：停止接收 做一次 checkpoint 后退出
+ */
+
+class VipServer {
+private:
+    static const size_t kReadChunk = 64 * 1024;
+    static const size_t kReadBudget = 16 * kReadChunk;   // 每轮每个连接最多读这么多 其他连接不会被饿死
+    static const size_t kMaxLineBytes = 64 * 1024;   // 一直没有换行就断开 防止缓冲区无限增长
+    static const size_t kMaxPendingOut = 4 << 20;    // 待发送回应超过这么多就先不读 / 不执行（背压）
+    static const int    kMaxEvents = 256;
+    static const size_t kJournalGroupSize = 1 << 20;  // 靠每轮的 syncJournal 提交 不按条数
+
+    struct Connection {
+        int    fd = -1;
+        string in;          // 还没凑成整行的输入
+        string out;         // 待发送的回应
+        size_t outPos = 0;
+        size_t synced = 0;  // out 的前这么多字节已经随日志落盘 之后的是这一轮新加的回应
+        uint32_t events = EPOLLIN;  // 当前注册的事件
+        bool   closing = false;   // 对端关闭 / 出错：发完剩余回应再关
+        bool   stalled = false;   // 回应积压停下了 in 里还有没执行的完整行
+
+        bool outputFull() const { return out.size() - outPos >= kMaxPendingOut; }
+    };
+
+    VipService& mService;
+    int         mListenFd = -1;
+    int         mEpollFd = -1;
+    string      mUnixPath;
+    unordered_map<int, Connection> mConnections;
+
+    uint64_t mRequests = 0;
+    uint64_t mAccepted = 0;
+
+    static volatile sig_atomic_t& stopFlag() {
+        static volatile sig_atomic_t flag = 0;
+        return flag;
+    }
+
+    static void onSignal(int) { stopFlag() = 1; }
+
+private:
+    VipServer(const VipServer&);
+    VipServer& operator=(const VipServer&);
+
+    static bool setNonBlocking(int fd) {
+        int flags = fcntl(fd, F_GETFL, 0);
+        return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+
+public:
+    explicit VipServer(VipService& service) : mService(service) {}
+
+    ~VipServer() {
+        for (auto& kv : mConnections) ::close(kv.first);
+        if (mListenFd >= 0) ::close(mListenFd);
+        if (mEpollFd >= 0) ::close(mEpollFd);
+        if (!mUnixPath.empty()) ::unlink(mUnixPath.c_str());
+    }
+
+    // address：unix:/path/to/sock 或 tcp:PORT 失败返回 false 并打印原因
+    bool listen(const string& address) {
+        if (address.compare(0, 5, "unix:") == 0) return listenUnix(address.substr(5));
+        if (address.compare(0, 4, "tcp:") == 0) return listenTcp(atoi(address.c_str() + 4));
+        fprintf(stderr, "地址格式：unix:/path 或 tcp:PORT\n");
+        return false;
+    }
+
+    // 事件循环 收到 SIGINT / SIGTERM 后返回
+    void run() {
+        signal(SIGPIPE, SIG_IGN);
+        signal(SIGINT, onSignal);
+        signal(SIGTERM, onSignal);
+        mService.setJournalGroupSize(kJournalGroupSize);
+
+        epoll_event events[kMaxEvents];
+        while (!stopFlag()) {
+            int n = epoll_wait(mEpollFd, events, kMaxEvents, 200);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                perror("epoll_wait");
+                break;
+            }
+
+            for (int i = 0; i < n; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == mListenFd) {
+                    acceptAll();
+                    continue;
+                }
+                auto it = mConnections.find(fd);
+                if (it == mConnections.end()) continue;
+                Connection& c = it->second;
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) readAndExecute(c);
+            }
+            // 之前因为回应积压停下的连接 回应发走一些后接着执行已经收到的行（不一定还有新的 EPOLLIN）
+            for (auto it = mConnections.begin(); it != mConnections.end(); ++it) {
+                Connection& c = it->second;
+                if (c.stalled && !c.outputFull()) executeLines(c);
+            }
+
+            // 这一轮所有命令的日志一次落盘 再发回应
+            const bool durable = mService.syncJournal();
+
+            for (auto it = mConnections.begin(); it != mConnections.end();) {
+                Connection& c = it->second;
+                if (!durable) VipService::failUnsynced(c.out, c.synced);
+                c.synced = c.out.size();
+                if (!c.out.empty() || c.closing) flush(c);
+                if (c.closing && !c.stalled && c.outPos >= c.out.size()) {
+                    ::close(c.fd);
+                    it = mConnections.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    uint64_t requests() const { return mRequests; }
+    uint64_t accepted() const { return mAccepted; }
+
+private:
+    bool setupEpoll() {
+        mEpollFd = epoll_create1(0);
+        if (mEpollFd < 0) { perror("epoll_create1"); return false; }
+        epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = mListenFd;
+        if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mListenFd, &ev) < 0) { perror("epoll_ctl"); return false; }
+        return true;
+    }
+
+    bool listenUnix(const string& path) {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+            fprintf(stderr, "套接字路径为空或过长\n");
+            return false;
+        }
+        memcpy(addr.sun_path, path.c_str(), path.size());
+
+        mListenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (mListenFd < 0) { perror("socket"); return false; }
+        ::unlink(path.c_str()); // 上次异常退出留下的套接字文件
+        if (bind(mListenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) { perror("bind"); return false; }
+        mUnixPath = path;
+        if (::listen(mListenFd, SOMAXCONN) < 0) { perror("listen"); return false; }
+        setNonBlocking(mListenFd);
+        return setupEpoll();
+    }
+
+    bool listenTcp(int port) {
+        if (port <= 0 || port > 65535) {
+            fprintf(stderr, "端口不合法\n");
+            return false;
+        }
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // 只给本机的收银终端用
+
+        mListenFd = socket(AF_INET, SOCK_STREAM, 0);
+        if (mListenFd < 0) { perror("socket"); return false; }
+        int one = 1;
+        setsockopt(mListenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(mListenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) { perror("bind"); return false; }
+        if (::listen(mListenFd, SOMAXCONN) < 0) { perror("listen"); return false; }
+        setNonBlocking(mListenFd);
+        return setupEpoll();
+    }
+
+    void acceptAll() {
+        while (true) {
+            int fd = accept(mListenFd, nullptr, nullptr);
+            if (fd < 0) return; // EAGAIN：这一批接完了
+            setNonBlocking(fd);
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // Unix 套接字上会失败 忽略
+
+            epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.events = EPOLLIN;
+            ev.data.fd = fd;
+            if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+                ::close(fd);
+                continue;
+            }
+            Connection& c = mConnections[fd];
+            c.fd = fd;
+            ++mAccepted;
+        }
+    }
+
+    // 读到 EAGAIN（或本轮额度用完 / 回应积压）为止 按行执行 回应追加到 out（暂不发送）
+    void readAndExecute(Connection& c) {
+        char buf[kReadChunk];
+        size_t budget = kReadBudget;
+        while (!c.closing && !c.stalled && !c.outputFull() && budget > 0) {
+            ssize_t n = ::read(c.fd, buf, sizeof(buf));
+            if (n > 0) {
+                c.in.append(buf, static_cast<size_t>(n));
+                budget -= min(budget, static_cast<size_t>(n));
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n < 0 && errno == EINTR) continue;
+            c.closing = true; // 0 = 对端关闭写端 仍然执行已经收到的完整行
+        }
+        executeLines(c);
+    }
+
+    // 执行 in 里的完整行 回应积压到 kMaxPendingOut 时停下（stalled）剩下的行留到回应发走之后
+    void executeLines(Connection& c) {
+        c.stalled = false;
+        size_t start = 0;
+        while (true) {
+            if (c.outputFull()) {
+                c.stalled = true;
+                break;
+            }
+            const char* b = c.in.data() + start;
+            const char* e = c.in.data() + c.in.size();
+            const char* nl = simd::findByte(b, e, '\n');
+            if (nl == e) break;
+
+            bool ok = true;
+            if (mService.executeLine(string_view(b, static_cast<size_t>(nl - b)), c.out, ok)) ++mRequests;
+            start = static_cast<size_t>(nl - c.in.data()) + 1;
+        }
+        c.in.erase(0, start);
+
+        if (!c.stalled && c.in.size() > kMaxLineBytes) {
+            c.out += "ERR 行太长\n";
+            c.in.clear();
+            c.closing = true;
+        }
+    }
+
+    void flush(Connection& c) {
+        while (c.outPos < c.out.size()) {
+            ssize_t n = ::send(c.fd, c.out.data() + c.outPos, c.out.size() - c.outPos, MSG_NOSIGNAL);
+            if (n > 0) { c.outPos += static_cast<size_t>(n); continue; }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            // 对端已经不在了 剩下的回应丢掉
+            c.outPos = c.out.size();
+            c.closing = true;
+            break;
+        }
+
+        if (c.outPos >= c.out.size()) {
+            c.out.clear();
+            c.outPos = 0;
+            c.synced = 0;
+        } else if (c.outPos >= kMaxPendingOut) {
+            // 对端一直在收但总也收不完：已发送的前缀删掉 out 不会越攒越长
+            c.out.erase(0, c.outPos);
+            c.synced -= c.outPos;
+            c.outPos = 0;
+        }
+
+        // 发不完才关心 EPOLLOUT；要关闭的 / 回应积压的连接不读
+        const bool readable = !c.closing && !c.stalled && !c.outputFull();
+        uint32_t want = (readable ? static_cast<uint32_t>(EPOLLIN) : 0u) | (c.out.empty() ? 0u : static_cast<uint32_t>(EPOLLOUT));
+        if (want != c.events) {
+            epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.events = want;
+            ev.data.fd = c.fd;
+            epoll_ctl(mEpollFd, EPOLL_CTL_MOD, c.fd, &ev);
+            c.events = want;
+        }
+    }
+};
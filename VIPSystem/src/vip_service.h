@@ -0,0 +1,1363 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <unistd.h>
+
+#include "member.h"
+#include "member_table.h"
+#include "transaction.h"
+#include "transaction_store.h"
+#include "leaderboard.h"
+#include "archive.h"
+#include "segment.h"
+#include "functors.h"
+#include "journal.h"
+#include "checkpoint.h"
+#include "command.h"
+#include "parallel_loader.h"
+#include "utility.h"
+#include "mpsc_queue.h"
+#include "bulk_import.h"
+#include "latency_recorder.h"
+#include "stats.h"
+
+using namespace std;
+
+/*
+ * VipService：线程安全的核心逻辑（没有任何 cin/cout）
+ * 菜单 / 批处理 / 多个收银通道 都调用这里
+ *
+ * 并发设计：
+ * - 会员按 id 哈希分到 kShardCount 个分片 每个分片一把读写锁 + 自己的 MemberTable
+ *   Member::addPoints 只在持有分片写锁时调用
+ * - 交易存储（TransactionStore）一把读写锁：查询之间互不阻塞 写入只在追加的瞬间独占
+ * - 交易号：atomic 自增 不需要锁
+ * - 积分排行榜（PointsLeaderboard）：一把互斥锁 积分变化时在分片写锁内同步更新
+ * - 日志：一把互斥锁（组提交本身就是把多次写合成一次）
+ *
+ * 加锁顺序（避免死锁）：会员分片（多个时按下标升序）-> 交易存储 -> 排行榜 -> 日志
+ * - 消费：分片写锁内 算折扣积分 + 追加交易 + 写日志 同一会员的操作天然有序
+ * - 删除：分片写锁内 删交易 + 删会员 + 写日志 不会和该会员的消费交错
+ * - checkpoint：所有分片读锁 + 交易读锁（二进制快照时是写锁）此时没有写操作 快照和日志截断是一致的
+ *   几个快照文件写成临时文件后一次提交（见 checkpoint.h）不会出现新旧混搭 日志第一行记着快照代数
+ *
+ * 对外返回的会员信息都是拷贝（MemberInfo）Member* 不出分片锁
+ *
+ * 消费入队（submitPurchase）：高峰期不让每笔消费都去抢锁
+ * - 生产者把请求推进无锁 MPSC 队列（见 mpsc_queue.h）立刻返回 future / 回调
+ * - 唯一的提交线程一次取一批：按分片下标升序锁住本批涉及的分片 算折扣积分
+ *   交易存储只加一次写锁整批追加 日志整批写入后一次 fsync 然后才兑现 future
+ *   所以 future 就绪 = 已经落盘（fsync 失败时结果里 durable = false）
+ * - 每笔从入队到兑现的延迟进 LatencyRecorder（ingestStats 查看 p50/p99/p999）
+ *
+ * 批量导入（importFile）：读取 / 解析 / 插入 三段流水线（见 bulk_import.h）
+ * - 插入每 kImportBatch 行一批 锁和日志的处理同提交线程：分片升序加锁 交易存储一次写锁 日志一次 fsync
+ * - 会员不存在时按行里的等级自动建档（MemberTable::emplace -> createMemberByLevel(place, ...) 在 arena 上构造）入会日期取首笔消费日期
+ *
+ * 归档（sealBefore）：早于某日期的交易封存为列式段文件（见 segment.h）清单见 archive.h
+ * - 清单由交易存储锁保护 封存 = 写段文件 -> 写清单（生效）-> 立即 checkpoint 文本快照不再含这些行
+ * - 删除会员时在清单里记水位线 下次 checkpoint 写盘 段里该会员的旧交易加载时丢弃
+ *
+ * 二进制快照（见 mapped_store.h）：<交易文件>.bin 存在时取代 transactions.txt + 段文件
+ * - 启动只 mmap + 校验文件头 交易号水位线取文件头 不读交易文本 启动时间和历史交易量无关
+ * - checkpoint 只写增量文件 <交易文件>.bin.delta（快照之后新增的交易 + 删掉的快照会员）交易存储读锁即可
+ * - 增量攒到快照的 1/4 才合并：快照 + 增量合写成新文件 和空增量一起提交 再换成新映射（这一次要独占锁）
+ * - convertToBinary（proc --convert）从现有文本快照 / 段文件 / 日志转换一次 之后文本文件不再读写
+ *   已经是二进制快照时 --convert 立即合并增量
+ *
+ * 每个公开操作都计时 + 记读写字节 / 扫描行数（见 stats.h -DVIP_NO_STATS 时不存在）
+ */
+
+struct MemberInfo {
+    string id;
+    string name;
+    string phone;
+    string levelName;
+    string joinDate;
+    int    levelCode = 0;
+    int    discountPercent = 100;
+    int    points = 0;
+
+    static MemberInfo of(const Member* m) {
+        MemberInfo info;
+        info.id = m->getId();
+        info.name = m->getName();
+        info.phone = m->getPhone();
+        info.levelName = m->levelName();
+        info.joinDate = m->getJoinDate();
+        info.levelCode = m->levelCode();
+        info.discountPercent = m->discountPercent();
+        info.points = m->getPoints();
+        return info;
+    }
+};
+
+struct PurchaseResult {
+    bool  ok = false;         // false：会员不存在
+    long  transactionId = 0;
+    Money amount;
+    Money pay;
+    int   pointsEarned = 0;
+    int   memberPoints = 0;   // 本次消费后的积分
+    bool  durable = true;     // false：已经记账 但日志写盘失败（下次 checkpoint 成功前重启会丢）
+};
+
+struct SealResult {
+    size_t rows = 0;
+    size_t segmentBytes = 0;
+    size_t textBytes = 0;     // 同样的行按 transactions.txt 格式的字节数（对比压缩效果）
+    string file;
+};
+
+struct ArchiveInfo {
+    size_t   segments = 0;
+    uint64_t rows = 0;        // 段文件里的行数（含之后删除会员的）
+    size_t   loadedRows = 0;  // 内存里仍有效的归档行
+};
+
+struct IngestStats {
+    uint64_t submitted = 0;
+    uint64_t committed = 0;
+    uint64_t rejected = 0;    // 会员不存在
+    uint64_t batches = 0;
+    uint64_t maxBatch = 0;
+    LatencySummary latency;   // 入队 -> future 兑现
+};
+
+class VipService {
+private:
+    static const size_t kShardCount = 16;
+    static const size_t kMaxIngestBatch = 1024;
+    static const size_t kImportBatch = 4096;
+
+    struct PurchaseRequest {
+        string id;
+        string date;
+        string item;
+        Money  amount;
+        chrono::steady_clock::time_point submitted;
+        promise<PurchaseResult> done;
+        function<void(const PurchaseResult&)> callback;  // 非空时用回调 不用 promise
+    };
+
+    // 一批消费里的一笔（commitBatch / importBatch 填好后交给 applyPurchases）
+    struct BatchPurchase {
+        const string*  id = nullptr;
+        const string*  item = nullptr;
+        string         date;             // 合法日期（“今天”由调用方先换好）
+        int            dateKey = 0;
+        Money          amount;
+        // 会员不存在时：autoCreate 就按 level / name / phone 建档（入会日期 = 本笔日期）否则这笔被拒
+        bool           autoCreate = false;
+        int            level = 0;
+        const string*  name = nullptr;
+        const string*  phone = nullptr;
+        PurchaseResult result;           // 输出
+    };
+
+    struct MemberShard {
+        mutable shared_mutex mutex;
+        MemberTable          members;
+    };
+
+    MemberShard mShards[kShardCount];
+
+    mutable shared_mutex mStoreMutex;
+    TransactionStore     mStore;
+    TransactionArchive   mArchive;    // 也由 mStoreMutex 保护（saveAll 在共享锁 + 日志锁下写清单 见 checkpointLocked）
+
+    mutable mutex     mRankMutex;
+    PointsLeaderboard mRanking;
+
+    atomic<long> mNextTransactionId;
+    functor::PointsCalculator mPointsCalculator;
+
+    string mMemberFilePath;
+    string mTransactionFilePath;
+    string mBinaryFilePath;
+    string mDeltaFilePath;
+    bool   mBinarySnapshot = false;   // 只在加载 / 转换时改（此时没有并发访问）
+
+    mutex              mJournalMutex;
+    Journal            mJournal;
+    CheckpointManifest mCheckpoint;   // 也由 mJournalMutex 保护
+
+    unsigned mLoadThreads = loader::defaultThreadCount();
+
+    // 消费入队 + 提交线程（第一次 submitPurchase 时才启动）
+    MpscQueue<PurchaseRequest> mIngestQueue;
+    thread                  mCommitter;
+    mutex                   mCommitterMutex;     // 启动/停止 + 睡眠唤醒
+    condition_variable      mCommitterWake;
+    atomic<bool>            mCommitterRunning{false};
+    atomic<bool>            mCommitterSleeping{false};
+    atomic<bool>            mStopping{false};
+    atomic<uint64_t>        mIngestSubmitted{0};
+    atomic<uint64_t>        mIngestCommitted{0};
+    atomic<uint64_t>        mIngestRejected{0};
+    atomic<uint64_t>        mIngestBatches{0};
+    atomic<uint64_t>        mIngestMaxBatch{0};
+    LatencyRecorder         mIngestLatency;
+
+private:
+    VipService(const VipService&);
+    VipService& operator=(const VipService&);
+
+    // 用哈希的高位选分片 低位留给 MemberTable 选槽 两边不相关
+    static size_t shardIndex(string_view id) {
+        return (hash<string_view>()(id) >> 56) % kShardCount;
+    }
+    MemberShard& shardOf(string_view id) { return mShards[shardIndex(id)]; }
+    const MemberShard& shardOf(string_view id) const { return mShards[shardIndex(id)]; }
+
+    void updateRanking(const string& id, int oldPoints, int newPoints) {
+        lock_guard<mutex> lock(mRankMutex);
+        mRanking.update(id, oldPoints, newPoints);
+    }
+
+    void journal(char tag, const string& body) {
+        lock_guard<mutex> lock(mJournalMutex);
+        mJournal.append(tag, body);
+    }
+
+public:
+    VipService(const string& memberFilePath, const string& transactionFilePath,
+               const string& journalFilePath)
+        : mArchive(transactionFilePath)
+        , mNextTransactionId(1)
+        , mMemberFilePath(memberFilePath)
+        , mTransactionFilePath(transactionFilePath)
+        , mBinaryFilePath(transactionFilePath + ".bin")
+        , mDeltaFilePath(mBinaryFilePath + ".delta")
+        , mJournal(journalFilePath)
+        , mCheckpoint(journalFilePath + ".checkpoint") {}
+
+    ~VipService() {
+        stopIngest();
+    }
+
+    // 加载 transactions.txt 用的线程数（默认 CPU 核数）
+    void setLoadThreads(unsigned n) { mLoadThreads = (n == 0 ? 1 : n); }
+
+    void setJournalGroupSize(size_t n) {
+        lock_guard<mutex> lock(mJournalMutex);
+        mJournal.setGroupSize(n);
+    }
+
+    // 把缓冲的日志记录落盘 失败返回 false（之前执行的写操作都不能回 OK 见 failUnsynced）
+    bool syncJournal() {
+        lock_guard<mutex> lock(mJournalMutex);
+        return mJournal.sync();
+    }
+
+    // 日志没落盘：response[from, end) 里的每条回应换成一条 ERR（条数不变 流水线的客户端仍能按顺序对上）
+    static void failUnsynced(string& response, size_t from) {
+        size_t lines = 0;
+        for (size_t i = from; i < response.size(); ++i) lines += (response[i] == '\n');
+        response.resize(from);
+        for (size_t i = 0; i < lines; ++i) response += "ERR 日志写盘失败\n";
+    }
+
+    size_t memberCount() const {
+        size_t n = 0;
+        for (size_t i = 0; i < kShardCount; ++i) {
+            shared_lock<shared_mutex> lock(mShards[i].mutex);
+            n += mShards[i].members.size();
+        }
+        return n;
+    }
+
+    size_t transactionCount() const {
+        shared_lock<shared_mutex> lock(mStoreMutex);
+        return mStore.size();
+    }
+
+    long nextTransactionId() const { return mNextTransactionId.load(); }
+
+    // ================== 会员 ==================
+
+    bool memberExists(const string& id) const {
+        const MemberShard& shard = shardOf(id);
+        shared_lock<shared_mutex> lock(shard.mutex);
+        return shard.members.contains(id);
+    }
+
+    bool getMember(const string& id, MemberInfo& out) const {
+        const MemberShard& shard = shardOf(id);
+        shared_lock<shared_mutex> lock(shard.mutex);
+        const Member* m = shard.members.find(id);
+        if (!m) return false;
+        out = MemberInfo::of(m);
+        return true;
+    }
+
+    // 会员信息 + 消费汇总（汇总随交易增量维护 不遍历交易）
+    // 两把锁按 分片 -> 交易 的顺序拿 两者是同一时刻的状态
+    bool getMemberSummary(const string& id, MemberInfo& out, MemberAggregate& agg) const {
+        VIP_STATS_TIMER(stats::kQueryMember);
+        const MemberShard& shard = shardOf(id);
+        shared_lock<shared_mutex> lock(shard.mutex);
+        const Member* m = shard.members.find(id);
+        if (!m) return false;
+        out = MemberInfo::of(m);
+        shared_lock<shared_mutex> storeLock(mStoreMutex);
+        agg = mStore.aggregate(id);
+        return true;
+    }
+
+    // 已存在返回 false
+    bool addMember(const string& id, const string& name, const string& phone, int levelCode,
+                   MemberInfo* out = nullptr) {
+        VIP_STATS_TIMER(stats::kAddMember);
+        MemberShard& shard = shardOf(id);
+        unique_lock<shared_mutex> lock(shard.mutex);
+        Member* m = shard.members.emplace(levelCode, id, name, phone, 0, util::todayDate());
+        if (!m) return false;
+        {
+            lock_guard<mutex> rankLock(mRankMutex);
+            mRanking.insert(id, m->getPoints());
+        }
+        journal('A', m->infoTxt());
+        if (out) *out = MemberInfo::of(m);
+        return true;
+    }
+
+    // name / phone 为空表示不改
+    bool editMember(const string& id, const string& name, const string& phone,
+                    MemberInfo* out = nullptr) {
+        VIP_STATS_TIMER(stats::kEditMember);
+        MemberShard& shard = shardOf(id);
+        unique_lock<shared_mutex> lock(shard.mutex);
+        Member* m = shard.members.find(id);
+        if (!m) return false;
+        if (!name.empty()) m->setName(name);
+        if (!phone.empty()) m->setPhone(phone);
+        journal('E', m->getId() + " | " + m->getName() + " | " + m->getPhone());
+        if (out) *out = MemberInfo::of(m);
+        return true;
+    }
+
+    // 删除会员时顺带删除其交易记录 避免孤儿交易->类比孤儿进程
+    bool deleteMember(const string& id) {
+        VIP_STATS_TIMER(stats::kDeleteMember);
+        MemberShard& shard = shardOf(id);
+        unique_lock<shared_mutex> lock(shard.mutex);
+        const Member* m = shard.members.find(id);
+        if (!m) return false;
+        {
+            unique_lock<shared_mutex> storeLock(mStoreMutex);
+            mStore.removeMember(id, m->levelCode());
+            mArchive.recordDelete(id, mNextTransactionId.load());
+        }
+        {
+            lock_guard<mutex> rankLock(mRankMutex);
+            mRanking.erase(id, m->getPoints());
+        }
+        // 析构会员对象 arena 槽回收复用
+        shard.members.erase(id);
+        journal('D', id);
+        return true;
+    }
+
+    // ================== 消费 ==================
+
+    // date 为空=今天（非空时调用方保证格式合法）item 为空=未填写 amount >= 0
+    // 会员不存在返回 false
+    bool purchase(const string& id, const string& date, const string& item, Money amount,
+                  PurchaseResult* out = nullptr) {
+        VIP_STATS_TIMER(stats::kPurchase);
+        MemberShard& shard = shardOf(id);
+        unique_lock<shared_mutex> lock(shard.mutex);
+        Member* m = shard.members.find(id);
+        if (!m) return false;
+
+        Transaction t;
+        t.transactionId = mNextTransactionId.fetch_add(1);
+        t.date = date.empty() ? util::todayDate() : date;
+        t.dateKey = util::dateToInt(t.date);
+        t.amount = amount;
+        // 不同等级折扣不同 整数分 * 百分比 四舍五入到分
+        t.pay = amount.applyPercent(m->discountPercent());
+        // 仿函数积分策略
+        t.pointsEarned = mPointsCalculator(t.pay);
+        const int oldPoints = m->getPoints();
+        m->addPoints(t.pointsEarned);
+
+        string rec;
+        {
+            unique_lock<shared_mutex> storeLock(mStoreMutex);
+            t.memberHandle = mStore.internMember(id);
+            t.itemCode = mStore.internItem(item.empty() ? string("未填写") : item);
+            mStore.append(t, m->levelCode());
+            mStore.appendTxt(t, rec);
+        }
+        updateRanking(id, oldPoints, m->getPoints());
+        journal('P', rec);
+
+        if (out) {
+            out->ok = true;
+            out->transactionId = t.transactionId;
+            out->amount = t.amount;
+            out->pay = t.pay;
+            out->pointsEarned = t.pointsEarned;
+            out->memberPoints = m->getPoints();
+        }
+        return true;
+    }
+
+    // ================== 消费入队（批量提交） ==================
+
+    // 入队后立即返回 future 兑现时交易已经写入并落盘
+    // date 为空=今天（非空时调用方保证格式合法）item 为空=未填写
+    future<PurchaseResult> submitPurchase(const string& id, const string& date, const string& item,
+                                          Money amount) {
+        PurchaseRequest req = makeRequest(id, date, item, amount);
+        future<PurchaseResult> f = req.done.get_future();
+        enqueue(std::move(req));
+        return f;
+    }
+
+    // 回调版本：在提交线程里调用 回调要快 不要再调用 submitPurchase 等待结果
+    void submitPurchase(const string& id, const string& date, const string& item, Money amount,
+                        function<void(const PurchaseResult&)> callback) {
+        PurchaseRequest req = makeRequest(id, date, item, amount);
+        req.callback = std::move(callback);
+        enqueue(std::move(req));
+    }
+
+    // 处理完队列里剩下的请求后停止提交线程（析构时自动调用）
+    // 调用前生产者要先停止提交
+    void stopIngest() {
+        unique_lock<mutex> lock(mCommitterMutex);
+        if (!mCommitterRunning) return;
+        mStopping = true;
+        mCommitterWake.notify_one();
+        // 提交线程睡眠时也要拿 mCommitterMutex join 前先放开
+        lock.unlock();
+        mCommitter.join();
+        lock.lock();
+        mCommitterRunning = false;
+        mStopping = false;
+    }
+
+    IngestStats ingestStats() const {
+        IngestStats st;
+        st.submitted = mIngestSubmitted.load();
+        st.committed = mIngestCommitted.load();
+        st.rejected = mIngestRejected.load();
+        st.batches = mIngestBatches.load();
+        st.maxBatch = mIngestMaxBatch.load();
+        st.latency = mIngestLatency.snapshot();
+        return st;
+    }
+
+    // ================== 批量导入 ==================
+
+    // path 为 "-" 时读 stdin workers 是解析线程数（0 = CPU 核数）
+    // 打不开 / 读出错返回 false（report.error 是原因 出错前的行已经导入）
+    bool importFile(const string& path, unsigned workers, bulk::ImportReport& report) {
+        FILE* in = (path == "-") ? stdin : fopen(path.c_str(), "rb");
+        if (!in) {
+            report.error = "无法打开 " + path;
+            return false;
+        }
+        if (workers == 0) workers = mLoadThreads;
+        bool durable = true;
+        bool ok = bulk::run(in, workers, report, [&](vector<bulk::ImportRow>& rows) {
+            size_t done = 0;
+            for (size_t b = 0; b < rows.size(); b += kImportBatch) {
+                done += importBatch(rows, b, min(rows.size(), b + kImportBatch), report.membersCreated);
+                if (!syncJournal()) durable = false;
+            }
+            return done;
+        });
+        if (in != stdin) fclose(in);
+        VIP_STATS_ADD(stats::kBytesRead, report.bytes);
+        if (ok && !durable) {
+            report.error = "日志写盘失败（已导入的行要等下次保存成功才落盘）";
+            return false;
+        }
+        return ok;
+    }
+
+    // ================== 查询（回调期间持有交易读锁 回调里不要再调用写接口） ==================
+
+    // fn(const Transaction&, const TransactionStore&) 返回交易条数
+    template <typename Fn>
+    size_t forEachMemberTransaction(const string& id, Fn fn) const {
+        VIP_STATS_TIMER(stats::kMemberTransactions);
+        shared_lock<shared_mutex> lock(mStoreMutex);
+        return mStore.forEachMemberTransaction(id, [&](const Transaction& t) { fn(t, mStore); });
+    }
+
+    // [fromKey, toKey] 按日期升序 memberId 为空表示全部会员
+    template <typename Fn>
+    size_t forEachTransactionBetween(int fromKey, int toKey, const string& memberId, Fn fn) const {
+        VIP_STATS_TIMER(stats::kQueryRange);
+        shared_lock<shared_mutex> lock(mStoreMutex);
+        return mStore.forEachBetween(fromKey, toKey, memberId, [&](const Transaction& t) { fn(t, mStore); });
+    }
+
+    // [fromKey, toKey] 全部会员的合计（列扫描 不逐条回调）
+    simd::RangeTotals rangeTotals(int fromKey, int toKey) const {
+        VIP_STATS_TIMER(stats::kQueryRange);
+        shared_lock<shared_mutex> lock(mStoreMutex);
+        return mStore.rangeTotals(fromKey, toKey);
+    }
+
+    // 按商品汇总 只返回有消费的商品（名字已经从字典取出）
+    vector<pair<string, ItemTotal>> itemTotals(int fromKey, int toKey) const {
+        VIP_STATS_TIMER(stats::kItemReport);
+        shared_lock<shared_mutex> lock(mStoreMutex);
+        return mStore.itemTotals(fromKey, toKey);
+    }
+
+    // ================== 排行榜 ==================
+
+    // 积分前 k 名 (会员号, 积分) O(log n + k)
+    vector<pair<string, int>> topByPoints(size_t k) const {
+        VIP_STATS_TIMER(stats::kLeaderboard);
+        lock_guard<mutex> lock(mRankMutex);
+        return mRanking.top(k);
+    }
+
+    // 会员的积分名次（1 起 同分同名次）total 是参与排名的会员数
+    bool memberRank(const string& id, MemberInfo& out, size_t& rank, size_t& total) const {
+        VIP_STATS_TIMER(stats::kLeaderboard);
+        const MemberShard& shard = shardOf(id);
+        shared_lock<shared_mutex> lock(shard.mutex);
+        const Member* m = shard.members.find(id);
+        if (!m) return false;
+        out = MemberInfo::of(m);
+        lock_guard<mutex> rankLock(mRankMutex);
+        rank = mRanking.rankOf(m->getPoints());
+        total = mRanking.size();
+        return true;
+    }
+
+    // [fromKey, toKey] 实付前 k 名 (会员号, 实付合计) fromKey == 0 表示不限日期
+    vector<pair<string, Money>> topSpenders(int fromKey, int toKey, size_t k) const {
+        VIP_STATS_TIMER(stats::kLeaderboard);
+        shared_lock<shared_mutex> lock(mStoreMutex);
+        vector<pair<uint32_t, Money>> top = mStore.topSpenders(fromKey, toKey, k);
+        vector<pair<string, Money>> out;
+        out.reserve(top.size());
+        for (size_t i = 0; i < top.size(); ++i) {
+            out.push_back(make_pair(string(mStore.memberIdOf(top[i].first)), top[i].second));
+        }
+        return out;
+    }
+
+    // ================== 营收汇总 ==================
+
+    // [fromKey, toKey] 按日 / 按月的桶（每桶按等级分开）fromKey == 0 表示不限
+    vector<pair<int, RollupBucket>> revenueBuckets(RevenueRollup::Granularity g, int fromKey, int toKey) const {
+        VIP_STATS_TIMER(stats::kRollup);
+        if (fromKey == 0) toKey = 99999999;
+        shared_lock<shared_mutex> lock(mStoreMutex);
+        return mStore.rollup().between(g, fromKey, toKey);
+    }
+
+    // [fromKey, toKey] 按等级合计 fromKey == 0 表示不限
+    RollupBucket revenueByLevel(int fromKey, int toKey) const {
+        VIP_STATS_TIMER(stats::kRollup);
+        if (fromKey == 0) toKey = 99999999;
+        shared_lock<shared_mutex> lock(mStoreMutex);
+        return mStore.rollup().total(fromKey, toKey);
+    }
+
+    // ================== 文本命令（批处理 / 服务端） ==================
+
+    // 执行一条已解析的命令 回应追加到 response（一行）
+    bool executeCommand(const Command& cmd, string& response) {
+        switch (cmd.type) {
+            case Command::kAdd: {
+                if (!addMember(cmd.id, cmd.name, cmd.phone, cmd.level)) {
+                    response += "ERR 该会员号已存在\n";
+                    return false;
+                }
+                response += "OK | " + cmd.id + "\n";
+                return true;
+            }
+            case Command::kEdit: {
+                if (!editMember(cmd.id, cmd.name, cmd.phone)) {
+                    response += "ERR 未找到该会员\n";
+                    return false;
+                }
+                response += "OK | " + cmd.id + "\n";
+                return true;
+            }
+            case Command::kDelete: {
+                if (!deleteMember(cmd.id)) {
+                    response += "ERR 未找到该会员\n";
+                    return false;
+                }
+                response += "OK | " + cmd.id + "\n";
+                return true;
+            }
+            case Command::kBuy: {
+                if (!cmd.date.empty() && util::dateToInt(cmd.date) == 0) {
+                    response += "ERR 日期格式不合法\n";
+                    return false;
+                }
+                PurchaseResult r;
+                if (!purchase(cmd.id, cmd.date, cmd.item, cmd.amount, &r)) {
+                    response += "ERR 未找到该会员\n";
+                    return false;
+                }
+
+                // OK | transactionId | pay | pointsEarned | 当前积分
+                response += "OK | ";
+                response += to_string(r.transactionId);
+                response += " | ";
+                response += r.pay.toString();
+                response += " | ";
+                response += to_string(r.pointsEarned);
+                response += " | ";
+                response += to_string(r.memberPoints);
+                response += "\n";
+                return true;
+            }
+            case Command::kQuery: {
+                MemberInfo m;
+                MemberAggregate agg;
+                if (!getMemberSummary(cmd.id, m, agg)) {
+                    response += "ERR 未找到该会员\n";
+                    return false;
+                }
+                // OK | id | name | level | points | 交易笔数 | 实付合计 | 累计积分
+                response += "OK | " + m.id + " | " + m.name + " | " + m.levelName
+                          + " | " + to_string(m.points) + " | " + to_string(agg.count)
+                          + " | " + agg.pay.toString() + " | " + to_string(agg.points) + "\n";
+                return true;
+            }
+            case Command::kRank: {
+                MemberInfo m;
+                size_t rank = 0, total = 0;
+                if (!memberRank(cmd.id, m, rank, total)) {
+                    response += "ERR 未找到该会员\n";
+                    return false;
+                }
+                // OK | id | points | 名次 | 会员数
+                response += "OK | " + m.id + " | " + to_string(m.points) + " | " + to_string(rank)
+                          + " | " + to_string(total) + "\n";
+                return true;
+            }
+            case Command::kTop: {
+                // OK | 条数 | id:值 | id:值 ...
+                string items;
+                size_t n = 0;
+                if (cmd.id == "points") {
+                    vector<pair<string, int>> top = topByPoints(cmd.limit);
+                    for (size_t i = 0; i < top.size(); ++i) items += " | " + top[i].first + ":" + to_string(top[i].second);
+                    n = top.size();
+                } else {
+                    vector<pair<string, Money>> top = topSpenders(util::dateToInt(cmd.date),
+                                                                  util::dateToInt(cmd.toDate), cmd.limit);
+                    for (size_t i = 0; i < top.size(); ++i) items += " | " + top[i].first + ":" + top[i].second.toString();
+                    n = top.size();
+                }
+                response += "OK | " + to_string(n) + items + "\n";
+                return true;
+            }
+            case Command::kReport: {
+                // OK | 条数 | key:笔数/原价/实付/积分 | ...  key 是 yyyymmdd / yyyymm / 等级名
+                const int fromKey = util::dateToInt(cmd.date);
+                const int toKey = util::dateToInt(cmd.toDate);
+                vector<pair<string, RollupCell>> rows;
+                if (cmd.id == "level") {
+                    RollupBucket b = revenueByLevel(fromKey, toKey);
+                    for (int lv = 0; lv < RollupBucket::kLevels; ++lv) rows.push_back(make_pair(levelNameOf(lv), b.level[lv]));
+                } else {
+                    vector<pair<int, RollupBucket>> buckets = revenueBuckets(
+                        cmd.id == "day" ? RevenueRollup::kDay : RevenueRollup::kMonth, fromKey, toKey);
+                    for (size_t i = 0; i < buckets.size(); ++i) {
+                        rows.push_back(make_pair(to_string(buckets[i].first), buckets[i].second.total()));
+                    }
+                }
+                response += "OK | " + to_string(rows.size());
+                for (size_t i = 0; i < rows.size(); ++i) {
+                    const RollupCell& c = rows[i].second;
+                    response += " | " + rows[i].first + ":" + to_string(c.count) + "/" + c.amount.toString()
+                              + "/" + c.pay.toString() + "/" + to_string(c.points);
+                }
+                response += "\n";
+                return true;
+            }
+            case Command::kSeal: {
+                if (usesBinarySnapshot()) {
+                    response += "ERR 二进制快照模式不需要封存\n";
+                    return false;
+                }
+                SealResult r;
+                if (!sealBefore(util::dateToInt(cmd.id), &r)) {
+                    response += r.rows > 0 ? "ERR 已封存 " + to_string(r.rows) + " 笔 但保存快照失败\n"
+                                           : string("ERR 写归档文件失败\n");
+                    return false;
+                }
+                // OK | 封存行数 | 段文件字节 | 文本字节 | 段文件名
+                response += "OK | " + to_string(r.rows) + " | " + to_string(r.segmentBytes) + " | "
+                          + to_string(r.textBytes) + " | " + r.file + "\n";
+                return true;
+            }
+            case Command::kCheckpoint:
+                if (!saveAll()) {
+                    response += "ERR 保存快照失败\n";
+                    return false;
+                }
+                response += "OK | CHECKPOINT\n";
+                return true;
+            case Command::kStats:
+                response += "OK | " + stats::reportLine() + "\n";
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // 执行一行命令 空行/注释返回 false；ok 表示命令是否成功
+    bool executeLine(string_view line, string& response, bool& ok) {
+        Command cmd;
+        string err;
+        if (!parseCommand(line, cmd, err)) {
+            ok = false;
+            response += "ERR " + err + "\n";
+            return true;
+        }
+        if (cmd.type == Command::kNone) return false;
+
+        ok = executeCommand(cmd, response);
+        return true;
+    }
+
+    // ================== 持久化 ==================
+
+    // 启动时调用（此时还没有并发访问）：快照 + 重放日志
+    // 二进制快照存在但打不开（文件头校验失败）返回 false：不能退回去读已经过时的文本快照
+    bool loadAll() {
+        VIP_STATS_TIMER(stats::kLoad);
+        // 上次 checkpoint 已生效但 rename 没做完：先补做 否则读到的是新旧混搭的快照
+        mCheckpoint.load();
+        if (!mCheckpoint.finish()) {
+            fprintf(stderr, "无法完成上次的 checkpoint（%s.checkpoint）\n", mJournal.path().c_str());
+            return false;
+        }
+        loadMembers();
+        mStore.clear();
+        mArchive.clear();
+        mBinarySnapshot = access(mBinaryFilePath.c_str(), F_OK) == 0;
+
+        if (mBinarySnapshot) {
+            // 只映射 + 校验文件头 日营收汇总随文件载入 交易号水位线取文件头 / 增量里大的那个
+            string err;
+            if (!mStore.attachBase(mBinaryFilePath, &err)) {
+                fprintf(stderr, "二进制快照 %s 无法打开：%s\n", mBinaryFilePath.c_str(), err.c_str());
+                return false;
+            }
+            long next = mStore.base().nextTransactionId();
+            long deltaNext = 0;
+            if (!mStore.loadDelta(mDeltaFilePath, [&](string_view id) {
+                    const Member* m = shardOf(id).members.find(id);
+                    return m ? m->levelCode() : 0;
+                }, &deltaNext, &err)) {
+                fprintf(stderr, "增量文件 %s 无法加载：%s\n", mDeltaFilePath.c_str(), err.c_str());
+                return false;
+            }
+            mNextTransactionId = max(max(next, deltaNext), mCheckpoint.nextTransactionId());
+        } else {
+            loadArchive();
+            mStore.loadFile(mTransactionFilePath, mLoadThreads);
+            mStore.rebuildIndexes();
+
+            // 自增交易号 避免程序重启后交易号重复
+            // 快照里最大的交易号可能属于已删除的会员（删了就不在快照里）：还要看 checkpoint 记的水位线
+            // 和归档清单（段 / 删除水位线）否则重新注册的会员拿到 < 水位线的交易号 封存后加载时被当成已删除丢掉
+            mNextTransactionId = max(max(mStore.maxTransactionId() + 1, mArchive.nextTransactionIdFloor()),
+                                     mCheckpoint.nextTransactionId());
+        }
+
+        const bool journalCurrent = replayJournal();
+        rebuildRanking();
+        // 二进制快照的营收汇总 attach 时已载入 重放的交易 append 时已累加
+        if (!mBinarySnapshot) rebuildRollup();
+
+        lock_guard<mutex> lock(mJournalMutex);
+        mJournal.setGeneration(mCheckpoint.generation());
+        // 旧代数的日志已经整个跳过 换成新代数的空日志再往后追加
+        if (!journalCurrent) mJournal.truncate(mCheckpoint.generation());
+        else mJournal.open();
+        return true;
+    }
+
+    // checkpoint：写完整快照 再清空日志
+    // 快照任意一步失败都保留日志 下次启动还能重放
+    bool saveAll() {
+        VIP_STATS_TIMER(stats::kSave);
+        vector<shared_lock<shared_mutex>> shardLocks;
+        for (size_t i = 0; i < kShardCount; ++i) shardLocks.emplace_back(mShards[i].mutex);
+        // 平时只写增量（或文本快照）读锁即可 查询可以继续；增量该合并时要换映射（rebase）交易存储要独占
+        // 先在读锁下看一眼 放锁到重新加锁之间又来的交易不影响：这次不合并就下次合并
+        bool merge = false;
+        if (mBinarySnapshot) {
+            shared_lock<shared_mutex> probe(mStoreMutex);
+            merge = mStore.needsMerge();
+        }
+        unique_lock<shared_mutex> storeWriteLock(mStoreMutex, defer_lock);
+        shared_lock<shared_mutex> storeReadLock(mStoreMutex, defer_lock);
+        if (merge) storeWriteLock.lock();
+        else storeReadLock.lock();
+        lock_guard<mutex> journalLock(mJournalMutex);
+        return checkpointLocked(merge);
+    }
+
+    // ================== 二进制快照 ==================
+
+    bool usesBinarySnapshot() const { return mBinarySnapshot; }
+    const string& binaryFilePath() const { return mBinaryFilePath; }
+
+    // 把当前全部交易（文本快照 + 段文件 + 日志重放的）写成二进制快照并 checkpoint
+    // 之后启动只映射这个文件 transactions.txt / 段文件不再读写（可以备份后删掉）
+    // 已经是二进制快照时：立即把增量合并进新快照
+    bool convertToBinary(size_t* bytes = nullptr) {
+        VIP_STATS_TIMER(stats::kSave);
+        vector<shared_lock<shared_mutex>> shardLocks;
+        for (size_t i = 0; i < kShardCount; ++i) shardLocks.emplace_back(mShards[i].mutex);
+        unique_lock<shared_mutex> storeLock(mStoreMutex);
+        lock_guard<mutex> journalLock(mJournalMutex);
+
+        const bool wasBinary = mBinarySnapshot;
+        mBinarySnapshot = true;
+        if (!checkpointLocked(true)) {
+            mBinarySnapshot = wasBinary;
+            return false;
+        }
+        mArchive.clear();   // 归档行已经写进二进制快照
+        if (bytes) *bytes = mStore.base().bytes();
+        return true;
+    }
+
+    // ================== 归档 ==================
+
+    // 把日期早于 beforeKey 的交易封存成一个段文件 然后立即 checkpoint
+    // 没有可封存的行返回 true 且 out->rows == 0；写文件失败 / 二进制快照模式返回 false（什么都不变）
+    // 封存已生效但之后的 checkpoint 失败：返回 false 且 out->rows > 0（文本快照下次 checkpoint 再去掉这些行）
+    bool sealBefore(int beforeKey, SealResult* out = nullptr) {
+        if (mBinarySnapshot) return false;   // 二进制快照本来就不解析文本 不需要封存
+        VIP_STATS_TIMER(stats::kSave);
+        vector<shared_lock<shared_mutex>> shardLocks;
+        for (size_t i = 0; i < kShardCount; ++i) shardLocks.emplace_back(mShards[i].mutex);
+        unique_lock<shared_mutex> storeLock(mStoreMutex);
+        lock_guard<mutex> journalLock(mJournalMutex);
+
+        SealResult r;
+        vector<size_t> positions = mStore.sealCandidates(beforeKey);
+        if (positions.empty()) {
+            if (out) *out = r;
+            return true;
+        }
+
+        // 交易按列存 要封存的行先拼出来（段文件按行写）
+        vector<Transaction> sealed(positions.size());
+        vector<const Transaction*> rows(positions.size());
+        string txt;
+        for (size_t i = 0; i < positions.size(); ++i) {
+            mStore.loadRow(positions[i], sealed[i]);
+            rows[i] = &sealed[i];
+            txt.clear();
+            mStore.appendTxt(*rows[i], txt);
+            r.textBytes += txt.size() + 1;
+        }
+
+        r.file = mArchive.nextSegmentFile();
+        segment::Header header;
+        const string path = mArchive.pathOf(r.file);
+        r.segmentBytes = segment::write(path, rows, mStore.dicts(), &header);
+        if (r.segmentBytes == 0) return false;
+        VIP_STATS_ADD(stats::kBytesWritten, r.segmentBytes);
+
+        // 清单写成功才算封存（之前崩溃只会留下一个没人引用的段文件）
+        mArchive.addSegment(r.file, header);
+        if (!mArchive.saveManifest()) {
+            mArchive.dropLastSegment();
+            remove(path.c_str());
+            return false;
+        }
+        mStore.markArchived(positions);
+        r.rows = positions.size();
+        if (out) *out = r;
+
+        // 文本快照去掉已封存的行（这一步之前崩溃：加载时按交易号去重）
+        return checkpointLocked();
+    }
+
+    ArchiveInfo archiveInfo() const {
+        shared_lock<shared_mutex> lock(mStoreMutex);
+        ArchiveInfo info;
+        info.segments = mArchive.segments().size();
+        info.rows = mArchive.rows();
+        info.loadedRows = mStore.archivedCount();
+        return info;
+    }
+
+private:
+    // ================== 提交线程 ==================
+
+    static PurchaseRequest makeRequest(const string& id, const string& date, const string& item,
+                                       Money amount) {
+        PurchaseRequest req;
+        req.id = id;
+        req.date = date;
+        req.item = item.empty() ? string("未填写") : item;
+        req.amount = amount;
+        req.submitted = chrono::steady_clock::now();
+        return req;
+    }
+
+    void enqueue(PurchaseRequest&& req) {
+        startCommitter();
+        mIngestSubmitted.fetch_add(1, memory_order_relaxed);
+        mIngestQueue.push(std::move(req));
+        // 和提交线程的 “先置 sleeping 再看队列” 配对（都是 seq_cst）不会丢唤醒
+        if (mCommitterSleeping.load()) {
+            lock_guard<mutex> lock(mCommitterMutex);
+            mCommitterWake.notify_one();
+        }
+    }
+
+    void startCommitter() {
+        if (mCommitterRunning.load(memory_order_acquire)) return;
+        lock_guard<mutex> lock(mCommitterMutex);
+        if (mCommitterRunning) return;
+        mCommitter = thread([this]() { commitLoop(); });
+        mCommitterRunning.store(true, memory_order_release);
+    }
+
+    void commitLoop() {
+        vector<PurchaseRequest> batch;
+        batch.reserve(kMaxIngestBatch);
+        while (true) {
+            PurchaseRequest req;
+            while (batch.size() < kMaxIngestBatch && mIngestQueue.pop(req)) batch.push_back(std::move(req));
+
+            if (!batch.empty()) {
+                commitBatch(batch);
+                batch.clear();
+                continue;
+            }
+            if (!mIngestQueue.empty()) {
+                this_thread::yield(); // 生产者正在挂节点
+                continue;
+            }
+            if (mStopping) return;
+
+            unique_lock<mutex> lock(mCommitterMutex);
+            mCommitterSleeping = true;
+            if (mIngestQueue.empty() && !mStopping) {
+                mCommitterWake.wait_for(lock, chrono::milliseconds(50));
+            }
+            mCommitterSleeping = false;
+        }
+    }
+
+    // 一批消费：公共部分见 applyPurchases 放开分片锁后再 fsync 最后兑现 future
+    void commitBatch(vector<PurchaseRequest>& batch) {
+        vector<BatchPurchase> items(batch.size());
+        for (size_t i = 0; i < batch.size(); ++i) {
+            PurchaseRequest& req = batch[i];
+            BatchPurchase& p = items[i];
+            p.id = &req.id;
+            p.item = &req.item;
+            p.date = req.date.empty() ? util::todayDate() : req.date;
+            p.dateKey = util::dateToInt(p.date);
+            p.amount = req.amount;
+        }
+        applyPurchases(items);
+        const bool durable = syncJournal();
+
+        const chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        vector<uint64_t> latency(batch.size());
+        uint64_t rejected = 0;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            PurchaseRequest& req = batch[i];
+            PurchaseResult& r = items[i].result;
+            if (!r.ok) ++rejected;
+            if (!durable) r.durable = false;
+            if (req.callback) req.callback(r);
+            else req.done.set_value(r);
+            latency[i] = static_cast<uint64_t>(
+                chrono::duration_cast<chrono::nanoseconds>(now - req.submitted).count());
+            VIP_STATS_RECORD(stats::kIngest, latency[i]);
+        }
+        mIngestLatency.record(latency.data(), latency.size());
+
+        mIngestCommitted.fetch_add(batch.size() - rejected, memory_order_relaxed);
+        mIngestRejected.fetch_add(rejected, memory_order_relaxed);
+        mIngestBatches.fetch_add(1, memory_order_relaxed);
+        if (batch.size() > mIngestMaxBatch.load(memory_order_relaxed)) mIngestMaxBatch = batch.size();
+    }
+
+    // 导入 rows[begin, end)：不存在的会员按行里的等级先建档 返回插入行数 调用方负责 syncJournal
+    size_t importBatch(vector<bulk::ImportRow>& rows, size_t begin, size_t end, size_t& membersCreated) {
+        VIP_STATS_TIMER(stats::kImport);
+        vector<BatchPurchase> items(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+            bulk::ImportRow& row = rows[i];
+            BatchPurchase& p = items[i - begin];
+            p.id = &row.memberId;
+            p.item = &row.item;
+            p.date = std::move(row.date);
+            p.dateKey = row.dateKey;
+            p.amount = row.amount;
+            p.autoCreate = true;
+            p.level = row.level;
+            p.name = &row.name;
+            p.phone = &row.phone;
+        }
+        membersCreated += applyPurchases(items);
+        return end - begin;
+    }
+
+    // 提交线程 / 批量导入共用：分片升序加锁 -> 逐笔（建档）算折扣积分 -> 交易存储一次写锁整批追加
+    // -> 排行榜 -> 日志整批写缓冲（本批新建会员的 A 在全部 P 之前）不 fsync 调用方放开锁后自己 syncJournal
+    // 结果写到每笔的 result 返回新建的会员数
+    size_t applyPurchases(vector<BatchPurchase>& batch) {
+        bool need[kShardCount] = {};
+        for (size_t i = 0; i < batch.size(); ++i) need[shardIndex(*batch[i].id)] = true;
+        vector<unique_lock<shared_mutex>> shardLocks;
+        for (size_t s = 0; s < kShardCount; ++s) {
+            if (need[s]) shardLocks.emplace_back(mShards[s].mutex);
+        }
+
+        vector<Transaction> rows;
+        rows.reserve(batch.size());
+        vector<size_t> rowOf(batch.size(), SIZE_MAX);
+        vector<pair<int, int>> pointsChange(batch.size());   // (旧积分, 新积分)
+        vector<int> levelOf(batch.size(), 0);
+        vector<string> created;                             // 新建会员的 A 记录
+        vector<size_t> createdAt;                           // 建档的那一笔的下标
+        for (size_t i = 0; i < batch.size(); ++i) {
+            BatchPurchase& p = batch[i];
+            MemberTable& table = shardOf(*p.id).members;
+            Member* m = table.find(*p.id);
+            if (!m && p.autoCreate) {
+                m = table.emplace(p.level, *p.id, *p.name, *p.phone, 0, p.date);
+                created.push_back(m->infoTxt());
+                createdAt.push_back(i);
+            }
+            if (!m) continue;
+
+            Transaction t;
+            t.transactionId = mNextTransactionId.fetch_add(1);
+            t.date = std::move(p.date);
+            t.dateKey = p.dateKey;
+            t.amount = p.amount;
+            t.pay = p.amount.applyPercent(m->discountPercent());
+            t.pointsEarned = mPointsCalculator(t.pay);
+            levelOf[i] = m->levelCode();
+            pointsChange[i].first = m->getPoints();
+            m->addPoints(t.pointsEarned);
+            pointsChange[i].second = m->getPoints();
+
+            PurchaseResult& r = p.result;
+            r.ok = true;
+            r.transactionId = t.transactionId;
+            r.amount = t.amount;
+            r.pay = t.pay;
+            r.pointsEarned = t.pointsEarned;
+            r.memberPoints = m->getPoints();
+
+            rowOf[i] = rows.size();
+            rows.push_back(std::move(t));
+        }
+
+        vector<string> recs(rows.size());
+        {
+            unique_lock<shared_mutex> storeLock(mStoreMutex);
+            for (size_t i = 0; i < batch.size(); ++i) {
+                if (rowOf[i] == SIZE_MAX) continue;
+                Transaction& t = rows[rowOf[i]];
+                t.memberHandle = mStore.internMember(*batch[i].id);
+                t.itemCode = mStore.internItem(*batch[i].item);
+                mStore.append(t, levelOf[i]);
+                mStore.appendTxt(t, recs[rowOf[i]]);
+            }
+        }
+        {
+            // 按批内顺序应用 同一会员多笔时每次的旧积分正好是上一笔的新积分
+            lock_guard<mutex> rankLock(mRankMutex);
+            for (size_t i = 0; i < createdAt.size(); ++i) mRanking.insert(*batch[createdAt[i]].id, 0);
+            for (size_t i = 0; i < batch.size(); ++i) {
+                if (rowOf[i] != SIZE_MAX) mRanking.update(*batch[i].id, pointsChange[i].first, pointsChange[i].second);
+            }
+        }
+        // 日志顺序必须和分片内的操作顺序一致（比如先 P 后 D）所以在分片锁内写缓冲
+        lock_guard<mutex> journalLock(mJournalMutex);
+        for (size_t i = 0; i < created.size(); ++i) mJournal.append('A', created[i]);
+        for (size_t i = 0; i < recs.size(); ++i) mJournal.append('P', recs[i]);
+        return created.size();
+    }
+
+    // id | name | phone | level | points | joinDate
+    // line 已经 trim 过 字段是指向 line 的 string_view 只有构造 Member 时才拷贝
+    // replace：id 已存在时是否覆盖（快照里重复的 id 以最后一行为准；日志重放不覆盖）
+    Member* parseMemberLine(string_view line, bool replace) {
+        array<string_view, 6> f;
+        if (!util::splitFields(line, f)) return nullptr;
+        if (f[0].empty()) return nullptr;
+
+        int levelCode = util::parseInt(f[3]);
+        int points = util::parseInt(f[4]);
+
+        // 根据 levelCode 在分片的 arena 里创建不同子类对象
+        return shardOf(f[0]).members.emplace(levelCode, string(f[0]), string(f[1]), string(f[2]),
+                                             points, string(f[5]), replace);
+    }
+
+    void loadMembers() {
+        for (size_t i = 0; i < kShardCount; ++i) mShards[i].members.clear();
+
+        string data;
+        if (!loader::readWholeFile(mMemberFilePath, data)) return; // 第一次运行没有文件很正常
+        VIP_STATS_ADD(stats::kBytesRead, data.size());
+
+        // 逐行切 string_view 不再 getline 拷贝每一行
+        loader::forEachLine(data.data(), data.data() + data.size(), [&](const char* b, const char* e) {
+            string_view line = util::trimView(string_view(b, static_cast<size_t>(e - b)));
+            if (line.empty()) return;
+
+            parseMemberLine(line, true);
+        });
+    }
+
+    // 在快照之上按顺序重放日志
+    // 交易号 <= 快照里最大交易号的消费已经在快照里了 跳过（避免 checkpoint 中途崩溃后重复记账）
+    // 注意用的是快照的水位线而不是当前的 mNextTransactionId：并发写入时日志里的交易号不保证递增
+    // 返回 false：日志第一行的代数比快照旧（checkpoint 提交后、截断日志前崩溃）记录都已经在快照里 整个跳过
+    // 没有代数行的旧日志照常重放
+    bool replayJournal() {
+        const long snapshotNextId = mNextTransactionId.load();
+
+        vector<string> records = Journal::readRecords(mJournal.path());
+        for (size_t i = 0; i < records.size(); ++i) {
+            const string& rec = records[i];
+            VIP_STATS_ADD(stats::kBytesRead, rec.size() + 1);
+            if (rec.size() < 4 || rec[1] != ' ' || rec[2] != '|') continue; // 损坏的记录
+            string_view body = string_view(rec).substr(4);
+
+            switch (rec[0]) {
+                case 'C':
+                    if (util::parseLong(body) < mCheckpoint.generation()) return false;
+                    break;
+                case 'A':
+                    parseMemberLine(body, false);
+                    break;
+                case 'E': {
+                    array<string_view, 3> f;
+                    if (!util::splitFields(body, f)) break;
+                    Member* m = shardOf(f[0]).members.find(f[0]);
+                    if (!m) break;
+                    m->setName(string(f[1]));
+                    m->setPhone(string(f[2]));
+                    break;
+                }
+                case 'D': {
+                    string id(util::trimView(body));
+                    MemberTable& members = shardOf(id).members;
+                    const Member* m = members.find(id);
+                    if (!m) break;
+                    mStore.removeMember(id, m->levelCode());
+                    mArchive.recordDelete(id, mNextTransactionId.load());
+                    members.erase(id);
+                    break;
+                }
+                case 'P': {
+                    Transaction t;
+                    if (!mStore.parseLine(body, t)) break;
+                    if (t.transactionId < snapshotNextId) break;
+                    string_view id = mStore.memberIdOf(t);
+                    Member* m = shardOf(id).members.find(id);
+                    if (!m) break;
+                    mStore.append(t, m->levelCode());
+                    m->addPoints(t.pointsEarned);
+                    if (t.transactionId >= mNextTransactionId) mNextTransactionId = t.transactionId + 1;
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+        return true;
+    }
+
+    // 调用方持有：全部分片读锁 + 交易存储锁（mergeBase 时必须是写锁）+ 日志锁
+    // 交易快照（或增量）/ members.txt / 归档清单（删除水位线）都先写临时文件 由 mCheckpoint 一次提交
+    // 提交之前失败：旧快照和日志都不动；提交之后：日志换成新代数（rename 没做完的下次启动补做）
+    // mergeBase：二进制快照模式下把增量合并成新快照（文本快照忽略）
+    bool checkpointLocked(bool mergeBase = false) {
+        mJournal.sync();   // 失败也继续：提交之前失败要靠日志 提交之后就不需要这些记录了
+        if (!mCheckpoint.finish()) return false;
+        mergeBase = mergeBase && mBinarySnapshot;
+        if (!saveTransactions(mergeBase) || !saveMembers() || !saveArchiveManifest()) {
+            mCheckpoint.discard();
+            return false;
+        }
+        if (!mCheckpoint.commit(mNextTransactionId.load())) return false;
+        mArchive.markSaved();
+
+        bool ok = mCheckpoint.finish();
+        if (ok && mergeBase) {
+            // 新快照已经就位 换成新映射（增量已经换成空的）
+            string err;
+            ok = mStore.rebase(mBinaryFilePath, &err);
+            if (!ok) fprintf(stderr, "二进制快照 %s 无法重新映射：%s\n", mBinaryFilePath.c_str(), err.c_str());
+        }
+        return mJournal.truncate(mCheckpoint.generation()) && ok;
+    }
+
+    // 按清单并行读段文件（每段一个任务）按清单顺序并入交易存储
+    // 校验失败的段跳过（保留文件 不删）
+    void loadArchive() {
+        mArchive.loadManifest();
+        const vector<TransactionArchive::SegmentInfo>& segs = mArchive.segments();
+        if (segs.empty()) return;
+
+        struct Part {
+            vector<Transaction> rows;
+            TransactionDicts    dicts;
+            segment::Header     header;
+            size_t              bytes = 0;
+            bool                ok = false;
+        };
+        vector<Part> parts(segs.size());
+        atomic<size_t> next(0);
+        auto worker = [&]() {
+            for (size_t i = next.fetch_add(1); i < segs.size(); i = next.fetch_add(1)) {
+                parts[i].ok = segment::read(mArchive.pathOf(segs[i].file), parts[i].rows, parts[i].dicts,
+                                            parts[i].header, &parts[i].bytes);
+            }
+        };
+        unsigned threads = mLoadThreads < segs.size() ? mLoadThreads : static_cast<unsigned>(segs.size());
+        if (threads <= 1) {
+            worker();
+        } else {
+            vector<thread> pool;
+            for (unsigned i = 0; i < threads; ++i) pool.push_back(thread(worker));
+            for (size_t i = 0; i < pool.size(); ++i) pool[i].join();
+        }
+
+        for (size_t i = 0; i < parts.size(); ++i) {
+            VIP_STATS_ADD(stats::kBytesRead, parts[i].bytes);
+            if (!parts[i].ok) {
+                fprintf(stderr, "归档段 %s 损坏 已跳过\n", segs[i].file.c_str());
+                continue;
+            }
+            mStore.appendArchived(parts[i].rows, parts[i].dicts, [&](string_view id) {
+                return mArchive.deleteWatermark(id);
+            });
+            vector<Transaction>().swap(parts[i].rows);
+        }
+    }
+
+    // 加载 / 重放完成后按最终积分整体重建（快照里重复的 id、日志里的删除都已经处理过）
+    void rebuildRanking() {
+        lock_guard<mutex> lock(mRankMutex);
+        mRanking.clear();
+        for (size_t i = 0; i < kShardCount; ++i) {
+            mShards[i].members.forEach([&](const Member* m) { mRanking.insert(m->getId(), m->getPoints()); });
+        }
+    }
+
+    // 交易文件里没有等级：按会员号编号查当前等级 再并行归约（见 rollup.h）
+    // 已不存在的会员留下的交易（旧快照）按普通会员计
+    void rebuildRollup() {
+        vector<int> levelOf(mStore.dicts().memberIds.size(), 0);
+        for (size_t i = 0; i < kShardCount; ++i) {
+            mShards[i].members.forEach([&](const Member* m) {
+                uint32_t handle = mStore.dicts().memberIds.find(m->getId());
+                if (handle != StringDict::kNone) levelOf[handle] = m->levelCode();
+            });
+        }
+        mStore.rebuildRollup(levelOf, mLoadThreads);
+    }
+
+    bool saveMembers() {
+        const string tmp = mMemberFilePath + ".tmp";
+        {
+            ofstream fout(tmp.c_str());
+            if (!fout) return false;
+
+            for (size_t i = 0; i < kShardCount; ++i) {
+                mShards[i].members.forEach([&](const Member* m) {
+                    // infoTxt() 的字段顺序必须和 loadMembers() 解析一致
+                    fout << m->infoTxt() << "\n";
+                });
+            }
+            if (!fout.flush()) return false;
+            VIP_STATS_ADD(stats::kBytesWritten, fout.tellp());
+        }
+        mCheckpoint.add(tmp, mMemberFilePath);
+        return true;
+    }
+
+    // 二进制快照：平时只写增量；mergeBase 时合写成新文件 + 叠在它上面的空增量（提交后 checkpointLocked 再换成新映射）
+    bool saveTransactions(bool mergeBase) {
+        if (mBinarySnapshot) {
+            const long next = mNextTransactionId.load();
+            uint64_t checksum = 0;
+            if (mergeBase) {
+                const string tmp = mBinaryFilePath + ".tmp";
+                size_t bytes = mStore.writeBinary(tmp, next, [&](string_view id) {
+                    const Member* m = shardOf(id).members.find(id);
+                    return m ? m->levelCode() : 0;
+                }, &checksum);
+                if (bytes == 0) return false;
+                VIP_STATS_ADD(stats::kBytesWritten, bytes);
+                mCheckpoint.add(tmp, mBinaryFilePath);
+            }
+            const string deltaTmp = mDeltaFilePath + ".tmp";
+            {
+                ofstream fout(deltaTmp.c_str());
+                if (!fout) return false;
+                if (mergeBase) fout << TransactionStore::deltaHeader(checksum, next);
+                else mStore.writeDelta(fout, next);
+                if (!fout.flush()) return false;
+                VIP_STATS_ADD(stats::kBytesWritten, fout.tellp());
+            }
+            mCheckpoint.add(deltaTmp, mDeltaFilePath);
+            return true;
+        }
+
+        const string tmp = mTransactionFilePath + ".tmp";
+        {
+            ofstream fout(tmp.c_str());
+            if (!fout) return false;
+            mStore.writeTxt(fout);
+            if (!fout.flush()) return false;
+            VIP_STATS_ADD(stats::kBytesWritten, fout.tellp());
+        }
+        mCheckpoint.add(tmp, mTransactionFilePath);
+        return true;
+    }
+
+    // 删除水位线有变化才写
+    bool saveArchiveManifest() {
+        if (!mArchive.dirty()) return true;
+        const string tmp = mArchive.manifestPath() + ".tmp";
+        if (!mArchive.writeManifest(tmp)) return false;
+        mCheckpoint.add(tmp, mArchive.manifestPath());
+        return true;
+    }
+};
@@ -1,24 +1,21 @@
 #pragma once
-#include <fstream>
-#include <map>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <iomanip>
-#include <cstdlib>
+#include <sstream>
+#include <algorithm>
 
-#include "member.h"
-#include "transaction.h"
-#include "functors.h"
+#include "vip_service.h"
 #include "utility.h"
 
 using namespace std;
 
 /*
- * VipSystem：系统核心
- * - mMembers：会员表（memberId -> Member*）
- * - mTransactions：交易记录表（顺序存储）
- * - 文件读写：members.txt / transactions.txt
+ * VipSystem：菜单 / 批处理 前端
+ * - 所有业务逻辑和数据都在 VipService（见 vip_service.h 线程安全）
+ * - 这里只负责 读输入 / 打印输出 打印用的是 MemberInfo 拷贝和查询回调 不持有任何 Member*
  *
  * 菜单：
  * 1 新增会员
@@ -26,42 +23,54 @@ using namespace std;
  * 3 删除会员（同时删除其交易记录，减少复杂分支）
  * 4 记录消费（多态折扣 + 仿函数积分）
  * 5 查询会员消费明细
+ * 6 按日期区间查询消费（可选单个会员 全部会员时合计走列扫描 见 column_scan.h）
+ * 7 商品销售汇总（按商品字典编号分组）
+ * 8 运行统计（各操作延迟分布 / 读写字节 / 扫描行数 见 stats.h）
+ * 9 排行榜（积分前 K 名 / 区间实付前 K 名 / 会员名次）
+ * 10 营收汇总（按日 / 按月 / 按会员等级 读物化汇总 不扫交易表 见 rollup.h）
+ * 11 归档旧交易（早于某日期的交易封存为列式段文件 见 segment.h）
+ * 12 批量导入历史消费（CSV / | 分隔文件 不存在的会员自动建档 见 bulk_import.h）
  * 0 保存并退出
+ *
+ * 批处理：runBatch 逐行执行 command.h 里的文本命令 没有提示和等待 最后统一保存
+ *
+ * 持久化：
+ * - members.txt / transactions.txt 是快照 只在 saveAll（checkpoint）时整体重写
+ *   转换成二进制快照（proc --convert）后交易快照换成 transactions.txt.bin（见 mapped_store.h）
+ *   + 增量 transactions.txt.bin.delta（平时 checkpoint 只写增量 攒多了才合并）
+ * - 每次修改立刻追加到 journal（见 journal.h）启动时 快照 + 重放日志 = 崩溃前的状态
+ * - checkpoint 的几个快照文件一次提交 提交记录 journal.log.checkpoint（见 checkpoint.h）
  * 
  * 设计：
- * 1) 多态：Member* 调用 virtual discountRate()/levelName() 实现不同等级折扣 
+ * 1) 多态：Member* 调用 virtual discountPercent()/levelName() 实现不同等级折扣 
  * 2) 仿函数：PointsCalculator 把“积分策略”独立出来，展示可替换策略 
- * 3) 文件持久化：Member/Transaction 各自提供 infoTxt()，VipSystem 负责读写与对象生命周期 
+ * 3) 文件持久化：Member/Transaction 各自提供 infoTxt()，VipService 负责读写与对象生命周期 
  *
  */
 
 class VipSystem {
 private:
-    map<string, Member*> mMembers;
-    vector<Transaction>  mTransactions;
+    static const size_t kDetailRows = 200;   // 区间查询超过这么多笔先只给合计
 
-    long mNextTransactionId = 1;
-    functor::PointsCalculator mPointsCalculator;
-
-    string mMemberFilePath;
-    string mTransactionFilePath;
+    VipService mService;
+    stats::StatsDumper mStatsDumper;
 
 private:
-    // 防止浅拷贝导致重复释放
     VipSystem(const VipSystem&);
     VipSystem& operator=(const VipSystem&);
 
 public:
-    VipSystem(const string& memberFilePath, const string& transactionFilePath)
-        : mMemberFilePath(memberFilePath)
-        , mTransactionFilePath(transactionFilePath) {}
+    VipSystem(const string& memberFilePath, const string& transactionFilePath,
+              const string& journalFilePath = "journal.log")
+        : mService(memberFilePath, transactionFilePath, journalFilePath) {}
 
-    ~VipSystem() {
-        clearMembers(); // 统一释放 Member*
-    }
+    VipService& service() { return mService; }
+
+    // 加载 transactions.txt 用的线程数（默认 CPU 核数）
+    void setLoadThreads(unsigned n) { mService.setLoadThreads(n); }
 
     void run() {
-        loadAll();
+        if (!mService.loadAll()) return;
 
         while (true) {
             cout << "\n========== 商场 VIP 消费查询系统 ==========\n";
@@ -70,6 +79,13 @@ public:
             cout << "3. 删除会员\n";
             cout << "4. 记录消费\n";
             cout << "5. 查询会员消费明细\n";
+            cout << "6. 按日期区间查询消费\n";
+            cout << "7. 商品销售汇总\n";
+            cout << "8. 运行统计\n";
+            cout << "9. 排行榜\n";
+            cout << "10. 营收汇总\n";
+            cout << "11. 归档旧交易\n";
+            cout << "12. 批量导入消费\n";
             cout << "0. 保存并退出\n";
             cout << "------------------------------------------\n";
             cout << "请输入菜单编号：";
@@ -83,15 +99,25 @@ public:
                 case 3: deleteMember(); break;
                 case 4: recordPurchase(); break;
                 case 5: queryMemberTransactions(); break;
+                case 6: queryTransactionsByDate(); break;
+                case 7: reportItemSales(); break;
+                case 8: showStats(); break;
+                case 9: showLeaderboard(); break;
+                case 10: showRevenue(); break;
+                case 11: sealOldTransactions(); break;
+                case 12: importPurchases(); break;
                 case 0:
-                    saveAll();
-                    cout << "已保存，退出 \n";
+                    if (mService.saveAll()) cout << "已保存，退出 \n";
+                    else cout << "保存快照失败（改动仍在日志里 下次启动会重放）\n";
                     return;
                 default:
                     cout << "无效选项 \n";
                     break;
             }
 
+            // 交互模式下每个操作结束就提交一次日志
+            if (!mService.syncJournal()) cout << "警告：日志写盘失败 本次修改要等下次保存成功才落盘\n";
+
             // cin >> 之后会残留 '\n' 用 ignore 等待回车
             cout << "按回车继续...";
             cin.ignore(1024, '\n');
@@ -100,144 +126,95 @@ public:
         }
     }
 
-private:
-    // ================== 内部工具 ==================
-
-    void clearMembers() {
-        // 释放 new 出来的 Member*
-        for (auto it = mMembers.begin(); it != mMembers.end(); ++it) {
-            delete it->second;
-            it->second = nullptr;
-        }
-        mMembers.clear();
-    }
-
-    Member* findMember(const string& memberId) const {
-        auto it = mMembers.find(memberId);
-        if (it == mMembers.end()) return nullptr;
-        return it->second;
-    }
+    // 定时把运行统计追加到 path（seconds 秒一次 退出时再写一次）
+    void startStatsDump(const string& path, unsigned seconds) { mStatsDumper.start(path, seconds); }
 
-    bool memberExists(const string& memberId) const {
-        return mMembers.find(memberId) != mMembers.end();
-    }
+    // 非交互批处理：每行一条命令（格式见 command.h）
+    // - 输出先攒在缓冲区 满 64KB 再写 out 写之前先把日志落盘（out 里出现的 OK 都已经落盘）
+    //   落盘失败时缓冲区里的回应都换成 ERR
+    // - 日志组提交放大到 kBatchGroupSize 条一次 fsync
+    // - checkpointEvery > 0 时每执行这么多条命令做一次 checkpoint 结束时再做一次
+    void runBatch(istream& in, ostream& out, size_t checkpointEvery = 0) {
+        const size_t kBatchGroupSize = 4096;
+        const size_t kOutputFlushBytes = 64 * 1024;
 
-    void printMemberSimple(const Member* m) const {
-        if (!m) return;
-        cout << "会员号=" << m->getId()
-             << " 姓名=" << m->getName()
-             << " 电话=" << m->getPhone()
-             << " 等级=" << m->levelName()
-             << " 积分=" << m->getPoints()
-             << " 入会=" << m->getJoinDate()
-             << "\n";
-    }
-
-    void printTransactionSimple(const Transaction& t) const {
-        cout << "交易#" << t.transactionId
-             << " 日期=" << t.date
-             << " 商品=" << t.item
-             << " 原价=" << fixed << setprecision(2) << t.amount
-             << " 实付=" << fixed << setprecision(2) << t.pay
-             << " 积分+" << t.pointsEarned
-             << "\n";
-    }
-
-    // ================== 文件读写 ==================
-
-    void loadMembers() {
-        
-        ifstream fin(mMemberFilePath.c_str());
-        if (!fin) return; // 第一次运行没有文件很正常
+        if (!mService.loadAll()) return;
+        mService.setJournalGroupSize(kBatchGroupSize);
 
         string line;
-        while (getline(fin, line)) {
-            line = util::trim(line);
-            if (line.empty()) continue;
-
-            // id | name | phone | level | points | joinDate
-            vector<string> p = util::splitByPipe(line);
-            if (p.size() < 6) continue;
-
-            string id = p[0];
-            if (id.empty()) continue;
-
-            string name = p[1];
-            string phone = p[2];
-            int levelCode = atoi(p[3].c_str());
-            int points = atoi(p[4].c_str());
-            string joinDate = p[5];
-
-            // 根据 levelCode 创建不同子类对象
-            mMembers[id] = createMemberByLevel(levelCode, id, name, phone, points, joinDate);
+        string buffer;
+        size_t executed = 0;
+        size_t failed = 0;
+        while (getline(in, line)) {
+            bool ok = true;
+            if (mService.executeLine(line, buffer, ok)) {
+                ++executed;
+                if (!ok) ++failed;
+                if (checkpointEvery > 0 && executed % checkpointEvery == 0) mService.saveAll();
+            }
+            if (buffer.size() >= kOutputFlushBytes) {
+                if (!mService.syncJournal()) VipService::failUnsynced(buffer, 0);
+                out << buffer;
+                buffer.clear();
+            }
         }
-        fin.close();
-    }
 
-    void loadTransactions() {
-        mTransactions.clear(); // 避免重复叠加
-
-        ifstream fin(mTransactionFilePath.c_str());
-        if (!fin) return;
-
-        string line;
-        while (getline(fin, line)) {
-            line = util::trim(line);
-            if (line.empty()) continue;
-
-            // transactionId | memberId | date | item | amount | pay | pointsEarned
-            vector<string> p = util::splitByPipe(line);
-            if (p.size() < 7) continue;
-
-            Transaction t;
-            t.transactionId = atol(p[0].c_str());
-            t.memberId = p[1];
-            t.date = p[2];
-            t.dateKey = util::dateToInt(t.date); 
-            t.item = p[3];
-            t.amount = atof(p[4].c_str());
-            t.pay = atof(p[5].c_str());
-            t.pointsEarned = atoi(p[6].c_str());
-
-            mTransactions.push_back(t);
-        }
-        fin.close();
+        // checkpoint 成功后日志已经清空 sync 直接返回 true；失败时还要靠日志
+        mService.saveAll();
+        if (!mService.syncJournal()) VipService::failUnsynced(buffer, 0);
+        buffer += "DONE | " + to_string(executed) + " | " + to_string(failed) + "\n";
+        out << buffer;
+        out.flush();
     }
 
-    void saveMembers() const {
-        ofstream fout(mMemberFilePath.c_str());
-        if (!fout) return;
-
-        for (auto it = mMembers.begin(); it != mMembers.end(); ++it) {
-            // infoTxt() 的字段顺序必须和 loadMembers() 解析一致
-            fout << it->second->infoTxt() << "\n";
+    // 批量导入消费文件（proc --import / 菜单 12）报告写到 out 打不开 / 读出错返回 false
+    // workers = 解析线程数（0 = CPU 核数）调用前已经 loadAll
+    bool importFile(const string& path, unsigned workers, ostream& out) {
+        bulk::ImportReport r;
+        const bool ok = mService.importFile(path, workers, r);
+        if (!r.error.empty()) out << r.error << "\n";
+        out << "导入 " << r.imported << " 笔 拒绝 " << r.rejected << " 行 新建会员 " << r.membersCreated
+            << " 用时 " << fixed << setprecision(2) << r.seconds << "s（" << setprecision(0) << r.rowsPerSecond()
+            << " 行/秒 " << setprecision(1) << (r.seconds > 0 ? r.bytes / r.seconds / 1e6 : 0.0) << " MB/s）\n";
+        out.unsetf(ios::floatfield);
+        out << setprecision(6);
+        for (size_t i = 0; i < r.samples.size(); ++i) {
+            out << "  第 " << r.samples[i].first << " 行：" << r.samples[i].second << "\n";
         }
+        if (r.rejected > r.samples.size()) out << "  ……其余 " << (r.rejected - r.samples.size()) << " 行略\n";
+        return ok;
     }
 
-    void saveTransactions() const {
-        ofstream fout(mTransactionFilePath.c_str());
-        if (!fout) return;
-
-        for (size_t i = 0; i < mTransactions.size(); ++i) {
-            fout << mTransactions[i].infoTxt() << "\n";
-        }
+    // 执行一行命令 回应追加到 response（一行）
+    // 空行/注释返回 false；ok 表示命令是否成功
+    bool executeLine(string_view line, string& response, bool& ok) {
+        return mService.executeLine(line, response, ok);
     }
 
-    void loadAll() {
-        loadMembers();
-        loadTransactions();
-
-        // 自增交易号 避免程序重启后交易号重复
-        long maxId = 0;
-        for (size_t i = 0; i < mTransactions.size(); ++i) {
-            if (mTransactions[i].transactionId > maxId) maxId = mTransactions[i].transactionId;
-        }
-        mNextTransactionId = maxId + 1;
+private:
+    // ================== 打印 ==================
+
+    static void printMemberSimple(const MemberInfo& m) {
+        cout << "会员号=" << m.id
+             << " 姓名=" << m.name
+             << " 电话=" << m.phone
+             << " 等级=" << m.levelName
+             << " 积分=" << m.points
+             << " 入会=" << m.joinDate
+             << "\n";
     }
 
-    void saveAll() const {
-        saveMembers();
-        saveTransactions();
+    // 在查询回调里调用（持有交易读锁）写到 out 缓冲 释放锁之后再统一输出
+    static void printTransactionSimple(ostream& out, const Transaction& t, const TransactionStore& store,
+                                       bool showMember = false) {
+        out << "交易#" << t.transactionId;
+        if (showMember) out << " 会员号=" << store.memberIdOf(t);
+        out << " 日期=" << t.date
+             << " 商品=" << store.itemOf(t)
+             << " 原价=" << t.amount
+             << " 实付=" << t.pay
+             << " 积分+" << t.pointsEarned
+             << "\n";
     }
 
     // ================== 菜单功能 ==================
@@ -249,7 +226,7 @@ private:
         cin >> id;
 
         if (id.empty()) { cout << "会员号不能为空 \n"; return; }
-        if (memberExists(id)) { cout << "该会员号已存在 \n"; return; }
+        if (mService.memberExists(id)) { cout << "该会员号已存在 \n"; return; }
 
         // 下面要 getline 先清掉 cin >> 的换行
         cin.ignore(1024, '\n');
@@ -263,11 +240,12 @@ private:
         int levelCode = util::readIntLine("等级(0普通 1VIP 2SVIP 回车默认0)：", 0);
         if (levelCode < 0 || levelCode > 2) levelCode = 0;
 
-        string joinDate = util::todayDate();
-        mMembers[id] = createMemberByLevel(levelCode, id, name, phone, 0, joinDate);
+        // 输入期间可能被别的通道抢先注册
+        MemberInfo m;
+        if (!mService.addMember(id, name, phone, levelCode, &m)) { cout << "该会员号已存在 \n"; return; }
 
         cout << "新增成功 \n";
-        printMemberSimple(mMembers[id]);
+        printMemberSimple(m);
     }
 
     void editMember() {
@@ -276,8 +254,8 @@ private:
         string id;
         cin >> id;
 
-        Member* m = findMember(id);
-        if (!m) { cout << "未找到该会员 \n"; return; }
+        MemberInfo m;
+        if (!mService.getMember(id, m)) { cout << "未找到该会员 \n"; return; }
 
         cout << "当前信息：\n";
         printMemberSimple(m);
@@ -286,11 +264,11 @@ private:
 
         cout << "新姓名(回车不改)：";
         string name; util::readLineSafe(name); name = util::trim(name);
-        if (!name.empty()) m->setName(name);
 
         cout << "新电话(回车不改)：";
         string phone; util::readLineSafe(phone); phone = util::trim(phone);
-        if (!phone.empty()) m->setPhone(phone);
+
+        if (!mService.editMember(id, name, phone, &m)) { cout << "未找到该会员 \n"; return; }
 
         cout << "修改完成：\n";
         printMemberSimple(m);
@@ -302,28 +280,18 @@ private:
         string id;
         cin >> id;
 
-        auto it = mMembers.find(id);
-        if (it == mMembers.end()) { cout << "未找到该会员 \n"; return; }
+        MemberInfo m;
+        if (!mService.getMember(id, m)) { cout << "未找到该会员 \n"; return; }
 
         cout << "将删除：\n";
-        printMemberSimple(it->second);
+        printMemberSimple(m);
 
         if (!util::readYesNo("确认删除？(y/n，回车默认n)：", false)) {
             cout << "已取消 \n";
             return;
         }
 
-        // 删除会员时顺带删除其交易记录 避免孤儿交易->类比孤儿进程
-        vector<Transaction> remain;
-        remain.reserve(mTransactions.size());
-        for (size_t i = 0; i < mTransactions.size(); ++i) {
-            if (mTransactions[i].memberId != id) remain.push_back(mTransactions[i]);
-        }
-        mTransactions.swap(remain);
-
-        // 先 delete 释放堆内存 再 erase 释放容器元素
-        delete it->second;
-        mMembers.erase(it);
+        if (!mService.deleteMember(id)) { cout << "未找到该会员 \n"; return; }
 
         cout << "删除成功（含该会员交易记录） \n";
     }
@@ -334,11 +302,11 @@ private:
         string id;
         cin >> id;
 
-        Member* m = findMember(id);
-        if (!m) { cout << "未找到该会员 \n"; return; }
+        MemberInfo m;
+        if (!mService.getMember(id, m)) { cout << "未找到该会员 \n"; return; }
 
-        cout << "会员等级=" << m->levelName()
-             << " 折扣=" << fixed << setprecision(2) << m->discountRate()
+        cout << "会员等级=" << m.levelName
+             << " 折扣=" << fixed << setprecision(2) << m.discountPercent / 100.0
              << "\n";
 
         cin.ignore(1024, '\n');
@@ -357,31 +325,15 @@ private:
         string item; util::readLineSafe(item); item = util::trim(item);
         if (item.empty()) item = "未填写";
 
-        double amount = util::readDoubleLine("原价金额：", 0.0);
-        if (amount < 0) amount = 0.0;
+        Money amount = util::readMoneyLine("原价金额：", Money());
+        if (amount < Money()) amount = Money();
 
-        // 不同等级折扣不同
-        double pay = amount * m->discountRate();
+        PurchaseResult r;
+        if (!mService.purchase(id, date, item, amount, &r)) { cout << "未找到该会员 \n"; return; }
 
-        // 仿函数积分策略
-        int points = mPointsCalculator(pay);
-
-        Transaction t;
-        t.transactionId = mNextTransactionId++;
-        t.memberId = id;
-        t.date = date;
-        t.dateKey = util::dateToInt(date);
-        t.item = item;
-        t.amount = amount;
-        t.pay = pay;
-        t.pointsEarned = points;
-
-        mTransactions.push_back(t);
-        m->addPoints(points);
-
-        cout << "记录成功：实付=" << fixed << setprecision(2) << pay
-             << " 积分+" << points
-             << " 当前积分=" << m->getPoints()
+        cout << "记录成功：实付=" << r.pay
+             << " 积分+" << r.pointsEarned
+             << " 当前积分=" << r.memberPoints
              << "\n";
     }
 
@@ -391,35 +343,304 @@ private:
         string id;
         cin >> id;
 
-        Member* m = findMember(id);
-        if (!m) { cout << "未找到该会员 \n"; return; }
+        MemberInfo m;
+        MemberAggregate agg;
+        if (!mService.getMemberSummary(id, m, agg)) { cout << "未找到该会员 \n"; return; }
 
         cout << "会员信息：\n";
         printMemberSimple(m);
 
-        // 收集该会员交易
-        vector<Transaction> list;
-        for (size_t i = 0; i < mTransactions.size(); ++i) {
-            if (mTransactions[i].memberId == id) list.push_back(mTransactions[i]);
-        }
-
-        if (list.empty()) {
+        if (agg.count == 0) {
             cout << "暂无消费记录 \n";
             return;
         }
 
+        // 汇总是增量维护的 不用遍历交易
+        cout << "合计：实付=" << agg.pay
+             << " 本次累计积分=" << agg.points
+             << "\n";
+        cout << "笔数=" << agg.count
+             << " 原价=" << agg.amount
+             << " 首次消费=" << util::intToDate(agg.firstDateKey)
+             << " 最近消费=" << util::intToDate(agg.lastDateKey)
+             << "\n";
+
+        cin.ignore(1024, '\n');
+        if (!util::readYesNo("显示明细？(y/n，回车默认n)：", false)) return;
+
+        // 走索引 只遍历该会员的交易 不扫描
+        ostringstream lines;
+        mService.forEachMemberTransaction(id, [&](const Transaction& t, const TransactionStore& store) {
+            printTransactionSimple(lines, t, store);
+        });
         cout << "消费记录：\n";
-        double sumPay = 0.0;
-        int sumPoints = 0;
+        cout << lines.str();
+    }
 
-        for (size_t i = 0; i < list.size(); ++i) {
-            printTransactionSimple(list[i]);
-            sumPay += list[i].pay;
-            sumPoints += list[i].pointsEarned;
+    void queryTransactionsByDate() {
+        cout << "\n[按日期区间查询消费]\n";
+        cin.ignore(1024, '\n');
+
+        cout << "开始日期(YYYY-MM-DD)：";
+        string from; util::readLineSafe(from); from = util::trim(from);
+        cout << "结束日期(YYYY-MM-DD 回车默认今天)：";
+        string to; util::readLineSafe(to); to = util::trim(to);
+        if (to.empty()) to = util::todayDate();
+
+        int fromKey = util::dateToInt(from);
+        int toKey = util::dateToInt(to);
+        if (fromKey == 0 || toKey == 0) { cout << "日期格式不合法 \n"; return; }
+        if (fromKey > toKey) { cout << "开始日期不能晚于结束日期 \n"; return; }
+
+        cout << "会员号(回车查询全部会员)：";
+        string id; util::readLineSafe(id); id = util::trim(id);
+        if (!id.empty() && !mService.memberExists(id)) { cout << "未找到该会员 \n"; return; }
+
+        // 全部会员：先在列上算合计 笔数多时再问要不要明细（和查询会员一样）
+        if (id.empty()) {
+            simd::RangeTotals totals = mService.rangeTotals(fromKey, toKey);
+            if (totals.count == 0) {
+                cout << "该区间暂无消费记录 \n";
+                return;
+            }
+            bool detail = totals.count <= kDetailRows;
+            if (!detail) {
+                cout << "共 " << totals.count << " 笔 " << util::intToDate(totals.minKey)
+                     << " ~ " << util::intToDate(totals.maxKey) << "\n";
+                detail = util::readYesNo("显示明细？(y/n，回车默认n)：", false);
+            }
+            if (detail) {
+                ostringstream lines;
+                mService.forEachTransactionBetween(fromKey, toKey, id,
+                    [&](const Transaction& t, const TransactionStore& store) { printTransactionSimple(lines, t, store, true); });
+                cout << lines.str();
+            }
+            cout << "合计：" << totals.count << " 笔"
+                 << " 原价=" << Money::fromCents(totals.amountCents)
+                 << " 实付=" << Money::fromCents(totals.payCents)
+                 << " 积分=" << totals.points
+                 << "\n";
+            return;
+        }
+
+        ostringstream lines;
+        Money sumAmount;
+        Money sumPay;
+        int sumPoints = 0;
+        size_t count = mService.forEachTransactionBetween(fromKey, toKey, id,
+            [&](const Transaction& t, const TransactionStore& store) {
+                printTransactionSimple(lines, t, store, false);
+                sumAmount += t.amount;
+                sumPay += t.pay;
+                sumPoints += t.pointsEarned;
+            });
+        if (count == 0) {
+            cout << "该区间暂无消费记录 \n";
+            return;
         }
 
-        cout << "合计：实付=" << fixed << setprecision(2) << sumPay
-             << " 本次累计积分=" << sumPoints
+        cout << lines.str();
+        cout << "合计：" << count << " 笔"
+             << " 原价=" << sumAmount
+             << " 实付=" << sumPay
+             << " 积分=" << sumPoints
              << "\n";
     }
+
+    void showStats() {
+        cout << "\n[运行统计]\n";
+        cout << stats::report();
+    }
+
+    void showLeaderboard() {
+        cout << "\n[排行榜]\n";
+        cin.ignore(1024, '\n');
+
+        int kind = util::readIntLine("1 积分排行 / 2 实付排行 / 3 查会员名次（回车默认1）：", 1);
+        if (kind == 3) {
+            cout << "会员号：";
+            string id; util::readLineSafe(id); id = util::trim(id);
+            MemberInfo m;
+            size_t rank = 0, total = 0;
+            if (!mService.memberRank(id, m, rank, total)) { cout << "未找到该会员 \n"; return; }
+            cout << "会员号=" << m.id << " 积分=" << m.points
+                 << " 名次=" << rank << "/" << total << "\n";
+            return;
+        }
+
+        int k = util::readIntLine("显示前几名（回车默认10）：", 10);
+        if (k <= 0) k = 10;
+
+        if (kind != 2) {
+            vector<pair<string, int>> top = mService.topByPoints(static_cast<size_t>(k));
+            if (top.empty()) { cout << "暂无会员 \n"; return; }
+            for (size_t i = 0; i < top.size(); ++i) {
+                cout << setw(4) << (i + 1) << ". 会员号=" << top[i].first << " 积分=" << top[i].second << "\n";
+            }
+            return;
+        }
+
+        // 默认本月
+        string today = util::todayDate();
+        string monthStart = today.substr(0, 8) + "01";
+        cout << "开始日期(YYYY-MM-DD 回车默认本月1日 输入 - 不限)：";
+        string from; util::readLineSafe(from); from = util::trim(from);
+        if (from.empty()) from = monthStart;
+
+        int fromKey = 0;
+        int toKey = 0;
+        if (from != "-") {
+            cout << "结束日期(YYYY-MM-DD 回车默认今天)：";
+            string to; util::readLineSafe(to); to = util::trim(to);
+            if (to.empty()) to = today;
+
+            fromKey = util::dateToInt(from);
+            toKey = util::dateToInt(to);
+            if (fromKey == 0 || toKey == 0) { cout << "日期格式不合法 \n"; return; }
+            if (fromKey > toKey) { cout << "开始日期不能晚于结束日期 \n"; return; }
+        }
+
+        vector<pair<string, Money>> top = mService.topSpenders(fromKey, toKey, static_cast<size_t>(k));
+        if (top.empty()) { cout << "该区间暂无消费记录 \n"; return; }
+        for (size_t i = 0; i < top.size(); ++i) {
+            cout << setw(4) << (i + 1) << ". 会员号=" << top[i].first << " 实付=" << top[i].second << "\n";
+        }
+    }
+
+    void showRevenue() {
+        cout << "\n[营收汇总]\n";
+        cin.ignore(1024, '\n');
+
+        int kind = util::readIntLine("1 按日 / 2 按月 / 3 按会员等级（回车默认2）：", 2);
+
+        cout << "开始日期(YYYY-MM-DD 回车不限)：";
+        string from; util::readLineSafe(from); from = util::trim(from);
+
+        int fromKey = 0;
+        int toKey = 0;
+        if (!from.empty()) {
+            cout << "结束日期(YYYY-MM-DD 回车默认今天)：";
+            string to; util::readLineSafe(to); to = util::trim(to);
+            if (to.empty()) to = util::todayDate();
+
+            fromKey = util::dateToInt(from);
+            toKey = util::dateToInt(to);
+            if (fromKey == 0 || toKey == 0) { cout << "日期格式不合法 \n"; return; }
+            if (fromKey > toKey) { cout << "开始日期不能晚于结束日期 \n"; return; }
+        }
+
+        auto printCell = [](const RollupCell& c) {
+            cout << " 笔数=" << c.count
+                 << " 原价=" << c.amount
+                 << " 实付=" << c.pay
+                 << " 积分=" << c.points;
+        };
+
+        if (kind == 3) {
+            RollupBucket b = mService.revenueByLevel(fromKey, toKey);
+            for (int lv = 0; lv < RollupBucket::kLevels; ++lv) {
+                cout << "等级=" << levelNameOf(lv);
+                printCell(b.level[lv]);
+                cout << "\n";
+            }
+            return;
+        }
+
+        const bool byDay = (kind == 1);
+        vector<pair<int, RollupBucket>> buckets =
+            mService.revenueBuckets(byDay ? RevenueRollup::kDay : RevenueRollup::kMonth, fromKey, toKey);
+        if (buckets.empty()) { cout << "该区间暂无消费记录 \n"; return; }
+
+        RollupCell sum;
+        ostringstream lines;
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            const int key = buckets[i].first;
+            RollupCell c = buckets[i].second.total();
+            sum.merge(c);
+            // 日：YYYY-MM-DD 月：YYYY-MM
+            lines << (byDay ? util::intToDate(key) : util::intToDate(key * 100 + 1).substr(0, 7))
+                  << " 笔数=" << c.count << " 原价=" << c.amount << " 实付=" << c.pay << " 积分=" << c.points
+                  << "\n";
+        }
+        cout << lines.str();
+        cout << "合计：";
+        printCell(sum);
+        cout << "\n";
+    }
+
+    void sealOldTransactions() {
+        cout << "\n[归档旧交易]\n";
+        cin.ignore(1024, '\n');
+        if (mService.usesBinarySnapshot()) {
+            cout << "当前使用二进制快照 " << mService.binaryFilePath() << "（启动不解析文本）不需要封存 \n";
+            return;
+        }
+
+        ArchiveInfo info = mService.archiveInfo();
+        cout << "当前归档：段文件=" << info.segments << " 归档交易=" << info.loadedRows
+             << " 未归档交易=" << (mService.transactionCount() - info.loadedRows) << "\n";
+
+        cout << "封存此日期之前的交易(YYYY-MM-DD)：";
+        string before; util::readLineSafe(before); before = util::trim(before);
+        int beforeKey = util::dateToInt(before);
+        if (beforeKey == 0) { cout << "日期格式不合法 \n"; return; }
+
+        SealResult r;
+        if (!mService.sealBefore(beforeKey, &r)) {
+            if (r.rows > 0) cout << "已封存 " << r.rows << " 笔到 " << r.file << " 但保存快照失败（下次保存时重试）\n";
+            else cout << "写归档文件失败 \n";
+            return;
+        }
+        if (r.rows == 0) { cout << "没有可封存的交易 \n"; return; }
+        cout << "已封存 " << r.rows << " 笔到 " << r.file
+             << "：" << r.segmentBytes << " 字节（文本 " << r.textBytes << " 字节）\n";
+    }
+
+    void importPurchases() {
+        cout << "\n[批量导入消费]\n";
+        cin.ignore(1024, '\n');
+        cout << "每行：会员号,日期,商品,原价[,等级,姓名,电话]（也可以用 | 分隔）不存在的会员自动建档\n";
+        cout << "文件路径：";
+        string path; util::readLineSafe(path); path = util::trim(path);
+        if (path.empty()) { cout << "未输入文件 \n"; return; }
+        importFile(path, 0, cout);
+    }
+
+    void reportItemSales() {
+        cout << "\n[商品销售汇总]\n";
+        cin.ignore(1024, '\n');
+
+        cout << "开始日期(YYYY-MM-DD 回车不限)：";
+        string from; util::readLineSafe(from); from = util::trim(from);
+
+        int fromKey = 0;
+        int toKey = 0;
+        if (!from.empty()) {
+            cout << "结束日期(YYYY-MM-DD 回车默认今天)：";
+            string to; util::readLineSafe(to); to = util::trim(to);
+            if (to.empty()) to = util::todayDate();
+
+            fromKey = util::dateToInt(from);
+            toKey = util::dateToInt(to);
+            if (fromKey == 0 || toKey == 0) { cout << "日期格式不合法 \n"; return; }
+            if (fromKey > toKey) { cout << "开始日期不能晚于结束日期 \n"; return; }
+        }
+
+        vector<pair<string, ItemTotal>> totals = mService.itemTotals(fromKey, toKey);
+        if (totals.empty()) { cout << "暂无消费记录 \n"; return; }
+
+        // 按实付从高到低
+        sort(totals.begin(), totals.end(), [](const pair<string, ItemTotal>& a, const pair<string, ItemTotal>& b) {
+            return a.second.pay > b.second.pay;
+        });
+
+        for (size_t i = 0; i < totals.size(); ++i) {
+            const ItemTotal& it = totals[i].second;
+            cout << "商品=" << totals[i].first
+                 << " 笔数=" << it.count
+                 << " 原价=" << it.amount
+                 << " 实付=" << it.pay
+                 << "\n";
+        }
+    }
 };